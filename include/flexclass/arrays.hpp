@@ -3,6 +3,16 @@
 
 #include "core.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
 /*! Contains builtin handle implementations for common applications
  *
  * A handle must derive from fc::Handle<T> and define the following
@@ -30,6 +40,43 @@
  * template <class Base>
  * auto end(const Base*) const -> T*;
  *
+ * [optional]
+ * // Called by the library to know where the storage of the array ends,
+ * // for handles that keep room for more elements past "end"
+ * // (e.g. to grow the array in place with fc::resize)
+ *
+ * template <class Base>
+ * auto capacity_end(const Base*) const -> T*;
+ *
+ * // Called by fc::resize after setLocation to let the handle know
+ * // the room available past "end"
+ *
+ * void setCapacityEnd(T* capacityEnd);
+ *
+ * [optional]
+ * // Alignment of the first T, if it must be stricter than alignof(T)
+ *
+ * static constexpr std::size_t fc_handle_alignment;
+ *
+ * [optional]
+ * // Places the array before the base instead of after it. The array
+ * // ends at the base if -1, or else at the array of that handle
+ * // (see PrecedingArray)
+ *
+ * static constexpr int fc_handle_precedes;
+ *
+ * [optional]
+ * // The handle stores the location of its array, which can then be
+ * // placed anywhere in the layout (see fc::SortByAlignment)
+ *
+ * static constexpr bool fc_handle_stores_location;
+ *
+ * [optional]
+ * // Builds the storage of the handle when it is not a plain array
+ * // of T, from the size argument passed to fc::make (see SoA)
+ *
+ * using fc_array_builder = Builder;
+ *
  */
 
 namespace fc
@@ -42,6 +89,8 @@ namespace fc
 template <class T>
 struct Array : Handle<T>
 {
+    static constexpr bool fc_handle_stores_location = true;
+
     using Handle<T>::Handle;
 
     void setLocation(T* begin, T* end) { m_begin = begin; }
@@ -63,6 +112,8 @@ struct Array : Handle<T>
 template <class T>
 struct Range : Handle<T>
 {
+    static constexpr bool fc_handle_stores_location = true;
+
     using Handle<T>::Handle;
 
     void setLocation(T* begin, T* end)
@@ -110,11 +161,11 @@ struct AdjacentArray : Handle<T>
     auto begin(const Base* ptr) const
     {
         if constexpr (El == -1)
-            return aligner(ptr, 1).template get<T>();
+            return adjacentBegin<T>(ptr);
         else
         {
-            auto e = ptr->fc_handles().template get<El>()->end(ptr);
-            return aligner(e).template get<T>();
+            auto&& handles = const_cast<Base*>(ptr)->fc_handles();
+            return aligner(storageEnd(*handles.template get<El>(), ptr)).template get<T>();
         }
     }
 };
@@ -141,9 +192,429 @@ struct AdjacentRange : Handle<T>
     auto begin(const Base* ptr) const
     {
         if constexpr (El == -1)
-            return aligner(ptr, 1).template get<T>();
+            return adjacentBegin<T>(ptr);
+        else
+        {
+            auto&& handles = const_cast<Base*>(ptr)->fc_handles();
+            return aligner(storageEnd(*handles.template get<El>(), ptr)).template get<T>();
+        }
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_end;
+    }
+
+    T* m_end;
+};
+
+/*! Like Range, but keeps room for more elements past the end
+ *  Arrays are created without extra room, which fc::resize may then reserve
+ *  according to a growth policy. Elements between end and capacity_end are
+ *  not constructed.
+ */
+template <class T>
+struct GrowableRange : Handle<T>
+{
+    static constexpr bool fc_handle_stores_location = true;
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        m_begin = begin;
+        m_end = m_capacityEnd = end;
+    }
+
+    void setCapacityEnd(T* capacityEnd) { m_capacityEnd = capacityEnd; }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return m_begin;
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_end;
+    }
+
+    template <class Base>
+    auto capacity_end(const Base* ptr) const
+    {
+        return m_capacityEnd;
+    }
+
+    auto begin() const { return m_begin; }
+    auto end() const { return m_end; }
+
+    std::size_t size() const { return m_end - m_begin; }
+    std::size_t capacity() const { return m_capacityEnd - m_begin; }
+
+    T* m_begin;
+    T* m_end;
+    T* m_capacityEnd;
+};
+
+/*! Stores the location of the first T as a byte offset from the handle itself
+ *  Position independent: the object can be copied byte by byte (e.g. to a file
+ *  mapped at another address) and remains valid. OffsetT is the unsigned type
+ *  of the offset, e.g. std::uint16_t when the array is known to be close.
+ */
+template <class T, class OffsetT = std::uint32_t>
+struct OffsetArray : Handle<T>
+{
+    static_assert(std::is_unsigned_v<OffsetT>, "The offset must be an unsigned type");
+
+    static constexpr bool fc_handle_stores_location = true;
+    static constexpr std::size_t fc_handle_max_offset = std::numeric_limits<OffsetT>::max();
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        auto offset = reinterpret_cast<std::byte*>(begin) - reinterpret_cast<std::byte*>(this);
+        assert(offset >= 0 && std::size_t(offset) <= std::numeric_limits<OffsetT>::max());
+        m_offset = static_cast<OffsetT>(offset);
+    }
+
+    template <class Base = void>
+    auto begin(const Base* ptr = nullptr) const
+    {
+        auto self = const_cast<std::byte*>(reinterpret_cast<const std::byte*>(this));
+        return reinterpret_cast<T*>(self + m_offset);
+    }
+
+    OffsetT m_offset;
+};
+
+/*! Like OffsetArray, but also stores the number of elements in a SizeT
+ *  With std::uint16_t offset and size it takes 4 bytes instead of 16 for a Range
+ */
+template <class T, class OffsetT = std::uint32_t, class SizeT = OffsetT>
+struct OffsetRange : Handle<T>
+{
+    static_assert(std::is_unsigned_v<OffsetT>, "The offset must be an unsigned type");
+    static_assert(std::is_unsigned_v<SizeT>, "The size must be an unsigned type");
+
+    static constexpr bool fc_handle_stores_location = true;
+    static constexpr std::size_t fc_handle_max_offset = std::numeric_limits<OffsetT>::max();
+    static constexpr std::size_t fc_handle_max_size = std::numeric_limits<SizeT>::max();
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        auto offset = reinterpret_cast<std::byte*>(begin) - reinterpret_cast<std::byte*>(this);
+        assert(offset >= 0 && std::size_t(offset) <= std::numeric_limits<OffsetT>::max());
+        assert(std::size_t(end - begin) <= std::numeric_limits<SizeT>::max());
+        m_offset = static_cast<OffsetT>(offset);
+        m_size = static_cast<SizeT>(end - begin);
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return begin();
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return end();
+    }
+
+    auto begin() const
+    {
+        auto self = const_cast<std::byte*>(reinterpret_cast<const std::byte*>(this));
+        return reinterpret_cast<T*>(self + m_offset);
+    }
+    auto end() const { return begin() + m_size; }
+
+    std::size_t size() const { return m_size; }
+
+    OffsetT m_offset;
+    SizeT m_size;
+};
+
+/*! Like AdjacentArray, but also stores the number of elements in a SizeT
+ *  "begin" is derived as in AdjacentArray and "end" is begin + size, so
+ *  the handle only takes sizeof(SizeT) bytes (e.g. 2 with std::uint16_t).
+ */
+template <class T, class SizeT = std::uint32_t, int El = -1>
+struct SizedArray : Handle<T>
+{
+    static_assert(std::is_unsigned_v<SizeT>, "The size must be an unsigned type");
+
+    static constexpr std::size_t fc_handle_max_size = std::numeric_limits<SizeT>::max();
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        assert(std::size_t(end - begin) <= std::numeric_limits<SizeT>::max());
+        m_size = static_cast<SizeT>(end - begin);
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return AdjacentArray<T, El>().begin(ptr);
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return begin(ptr) + m_size;
+    }
+
+    std::size_t size() const { return m_size; }
+
+    SizeT m_size;
+};
+
+/*! Array placed before the base, in the same allocation
+ *  With El == -1 the array ends at the base, otherwise it ends at the begin
+ *  of the array of the El-th handle, which must precede the base too. Only
+ *  the number of elements is stored: "begin" is end - size. This is the
+ *  layout of the operands of an llvm::User, which are reached from the
+ *  object without storing any pointer.
+ *
+ *  Preceding arrays come first in fc_handles(), stacked downwards: the first
+ *  one uses El == -1 and the I-th one El == I - 1. fc::make then allocates
+ *  room below the base and fc::destroy releases it from its start.
+ */
+template <class T, class SizeT = std::uint32_t, int El = -1>
+struct PrecedingArray : Handle<T>
+{
+    static_assert(std::is_unsigned_v<SizeT>, "The size must be an unsigned type");
+
+    static constexpr int fc_handle_precedes = El;
+    static constexpr std::size_t fc_handle_max_size = std::numeric_limits<SizeT>::max();
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        assert(std::size_t(end - begin) <= std::numeric_limits<SizeT>::max());
+        m_size = static_cast<SizeT>(end - begin);
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return end(ptr) - m_size;
+    }
+
+    template <class Base>
+    T* end(const Base* ptr) const
+    {
+        if constexpr (El == -1)
+            return reinterpret_cast<T*>(const_cast<Base*>(ptr));
         else
-            return aligner(ptr->template end<El>()).template get<T>();
+        {
+            auto&& handles = const_cast<Base*>(ptr)->fc_handles();
+            auto next = reinterpret_cast<std::uintptr_t>(handles.template get<El>()->begin(ptr));
+            return reinterpret_cast<T*>(next & ~std::uintptr_t(alignof(T) - 1));
+        }
+    }
+
+    std::size_t size() const { return m_size; }
+
+    SizeT m_size;
+};
+
+/*! Struct of arrays: one array per column type Ts, all with the same size
+ *  Created from a single size (or fc::zeroed), the columns are laid out one
+ *  after the other, each one aligned for its type. Only the first column and
+ *  the number of elements are stored:
+ *
+ *    fc::SoA<int, float, bool> particles;
+ *    for (float weight : particles.column<1>()) ...
+ *
+ *  Columns must be trivially copyable, so that the whole storage can be
+ *  handled as bytes, which is what begin and end refer to.
+ */
+template <class... Ts>
+struct SoA : Handle<std::byte>
+{
+    static_assert(sizeof...(Ts) > 0, "A SoA needs at least one column");
+    static_assert((std::is_trivially_copyable_v<Ts> && ...),
+                  "SoA columns must be trivially copyable");
+
+    static constexpr std::size_t fc_handle_alignment = std::max({alignof(Ts)...});
+    static constexpr bool fc_handle_stores_location = true;
+
+    static constexpr std::size_t numColumns = sizeof...(Ts);
+    static constexpr std::size_t rowBytes = (sizeof(Ts) + ...);
+
+    //! Byte offset of each column for "size" elements, followed by the end of the last one
+    static constexpr auto columnOffsets(std::size_t size)
+    {
+        std::array<std::size_t, numColumns + 1> offsets{};
+        std::size_t offset = 0, i = 0;
+        ((offset = findNextAlignedPosition(offset, alignof(Ts)), offsets[i++] = offset,
+          offset += size * sizeof(Ts)),
+         ...);
+        offsets[numColumns] = offset;
+        return offsets;
+    }
+
+    //! Creates every column from the same size argument
+    struct Builder
+    {
+        static constexpr std::size_t numRequiredBytes(std::size_t offset, std::size_t size)
+        {
+            return findNextAlignedPosition(offset, fc_handle_alignment) - offset +
+                   columnOffsets(size)[numColumns];
+        }
+
+        template <class InputIt>
+        static constexpr bool isNothrowBuildable()
+        {
+            return (ArrayBuilder<Ts>::template isNothrowBuildable<InputIt>() && ...);
+        }
+
+        template <class InputIt>
+        std::byte* buildArray(std::byte* buf, Arg<InputIt>& arg)
+        {
+            static_assert(std::is_same_v<InputIt, detail::NoIterator> ||
+                              std::is_same_v<InputIt, detail::Zeroed>,
+                          "SoA columns are created from a size or fc::zeroed");
+
+            auto aligned = findNextAlignedPosition(buf, fc_handle_alignment);
+            auto b = reinterpret_cast<std::byte*>(aligned);
+            buildColumns(b, columnOffsets(arg.m_size), arg,
+                         std::make_index_sequence<numColumns>());
+            m_begin = b;
+            m_end = b + columnOffsets(arg.m_size)[numColumns];
+            return m_end;
+        }
+
+        template <class Offsets, class InputIt, std::size_t... I>
+        static void buildColumns(std::byte* b, const Offsets& offsets, Arg<InputIt>& arg,
+                                 std::index_sequence<I...>)
+        {
+            // Columns are trivially destructible: nothing to roll back
+            (ArrayBuilder<Ts>().buildArray(b + offsets[I], arg), ...);
+        }
+
+        void release() {}
+
+        std::byte* m_begin{nullptr};
+        std::byte* m_end{nullptr};
+    };
+
+    using fc_array_builder = Builder;
+
+    using Handle<std::byte>::Handle;
+
+    void setLocation(std::byte* begin, std::byte* end)
+    {
+        // The padding between columns is less than a row, so the division is exact
+        m_begin = begin;
+        m_size = std::size_t(end - begin) / rowBytes;
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return m_begin;
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_begin + columnOffsets(m_size)[numColumns];
+    }
+
+    std::size_t size() const { return m_size; }
+
+    //! The I-th column
+    template <std::size_t I>
+    auto column() const
+    {
+        using T = TypeAtIdx<I, Ts...>;
+        auto b = reinterpret_cast<T*>(m_begin + columnOffsets(m_size)[I]);
+        return span<T>{b, b + m_size};
+    }
+
+    std::byte* m_begin;
+    std::size_t m_size;
+};
+
+/*! Array of bits, created from a number of bits
+ *  The bits are packed in 64-bit words, cleared on creation. A leading word
+ *  holds the number of bits, so "size" is the number passed to fc::make.
+ *  "count" and "find_next" process a word at a time, with popcount and
+ *  trailing zero count instructions (e.g. with -mpopcnt -mbmi on x86).
+ */
+struct BitArray : Handle<std::uint64_t>
+{
+    using Word = std::uint64_t;
+
+    static constexpr std::size_t wordBits = 64;
+    static constexpr std::size_t npos = std::size_t(-1);
+    static constexpr bool fc_handle_stores_location = true;
+
+    static constexpr std::size_t numWords(std::size_t numBits)
+    {
+        return (numBits + wordBits - 1) / wordBits;
+    }
+
+    //! Creates the leading number of bits and the words holding them
+    struct Builder
+    {
+        static constexpr std::size_t numRequiredBytes(std::size_t offset, std::size_t numBits)
+        {
+            return ArrayBuilder<Word>::numRequiredBytes(offset, 1 + numWords(numBits));
+        }
+
+        template <class InputIt>
+        static constexpr bool isNothrowBuildable()
+        {
+            return true;
+        }
+
+        template <class InputIt>
+        std::byte* buildArray(std::byte* buf, Arg<InputIt>& arg)
+        {
+            static_assert(std::is_same_v<InputIt, detail::NoIterator> ||
+                              std::is_same_v<InputIt, detail::Zeroed>,
+                          "BitArray is created from a number of bits or fc::zeroed");
+
+            m_begin = reinterpret_cast<Word*>(findNextAlignedPosition(buf, alignof(Word)));
+            m_end = m_begin + 1 + numWords(arg.m_size);
+
+            // Zeroed arrays were cleared when the memory was allocated
+            if constexpr (std::is_same_v<InputIt, detail::NoIterator>)
+                std::fill(m_begin + 1, m_end, Word(0));
+            m_begin[0] = arg.m_size;
+            return reinterpret_cast<std::byte*>(m_end);
+        }
+
+        void release() {}
+
+        Word* m_begin{nullptr};
+        Word* m_end{nullptr};
+    };
+
+    using fc_array_builder = Builder;
+
+    using Handle<Word>::Handle;
+
+    void setLocation(Word* begin, Word* end)
+    {
+        m_begin = begin;
+        m_end = end;
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return m_begin;
     }
 
     template <class Base>
@@ -152,6 +623,701 @@ struct AdjacentRange : Handle<T>
         return m_end;
     }
 
+    //! The words holding the bits, after the leading number of bits
+    span<Word> words() const { return {m_begin + 1, m_end}; }
+
+    std::size_t size() const { return m_begin[0]; }
+
+    bool test(std::size_t i) const
+    {
+        assert(i < size());
+        return (m_begin[1 + i / wordBits] >> (i % wordBits)) & 1;
+    }
+
+    void set(std::size_t i)
+    {
+        assert(i < size());
+        m_begin[1 + i / wordBits] |= Word(1) << (i % wordBits);
+    }
+
+    void reset(std::size_t i)
+    {
+        assert(i < size());
+        m_begin[1 + i / wordBits] &= ~(Word(1) << (i % wordBits));
+    }
+
+    void set(std::size_t i, bool value) { value ? set(i) : reset(i); }
+
+    //! Number of bits set
+    std::size_t count() const
+    {
+        std::size_t n = 0;
+        for (auto w = m_begin + 1; w != m_end; ++w)
+            n += popcount(*w);
+        return n;
+    }
+
+    //! Index of the first bit set, or npos
+    std::size_t find_first() const { return find_next(0); }
+
+    //! Index of the first bit set at or after "pos", or npos
+    std::size_t find_next(std::size_t pos) const
+    {
+        // Checked before forming a pointer that could be past the end
+        if (pos >= size())
+            return npos;
+
+        auto words = m_begin + 1;
+        auto w = words + pos / wordBits;
+        auto word = *w & (~Word(0) << (pos % wordBits));
+        while (!word)
+        {
+            if (++w == m_end)
+                return npos;
+            word = *w;
+        }
+        return (w - words) * wordBits + countTrailingZeros(word);
+    }
+
+    Word* m_begin;
+    Word* m_end;
+};
+
+/*! Array of unsigned integers of "Bits" bits each, packed in 64-bit words
+ *  Created like any array (from a size, fc::fill, fc::zeroed or an iterator
+ *  over integers), whose values are truncated to "Bits" bits. The first word
+ *  holds the number of values, so the handle only stores one pointer and the
+ *  array remains valid when relocated.
+ *
+ *  "get" decodes a single value. "decode" decodes a range of values: every
+ *  64 values take exactly "Bits" words, so full blocks are decoded with
+ *  compile time shifts and masks, which the compiler can vectorize.
+ */
+template <unsigned Bits>
+struct PackedIntArray : Handle<std::uint64_t>
+{
+    static_assert(Bits > 0 && Bits <= 64, "Values must take between 1 and 64 bits");
+
+    using Word = std::uint64_t;
+    using value_type = std::conditional_t<(Bits <= 32), std::uint32_t, std::uint64_t>;
+
+    static constexpr std::size_t wordBits = 64;
+    static constexpr Word mask = Bits == wordBits ? ~Word(0) : (Word(1) << Bits) - 1;
+    static constexpr bool fc_handle_stores_location = true;
+
+    //! Number of words holding "size" values, without the leading size
+    static constexpr std::size_t numWords(std::size_t size)
+    {
+        return (size * Bits + wordBits - 1) / wordBits;
+    }
+
+    //! The i-th value packed in "words"
+    static Word extract(const Word* words, std::size_t i)
+    {
+        auto bit = i * Bits;
+        auto w = bit / wordBits;
+        auto shift = bit % wordBits;
+
+        auto value = words[w] >> shift;
+        if (shift + Bits > wordBits)
+            value |= words[w + 1] << (wordBits - shift);
+        return value & mask;
+    }
+
+    /*! Stores "value" as the i-th value in "words", whose bits must be cleared
+     *  Only the low "Bits" bits of "value" are kept, the others would
+     *  overwrite the neighbouring values.
+     */
+    static void insert(Word* words, std::size_t i, Word value)
+    {
+        value &= mask;
+        auto bit = i * Bits;
+        auto w = bit / wordBits;
+        auto shift = bit % wordBits;
+
+        words[w] |= value << shift;
+        if (shift + Bits > wordBits)
+            words[w + 1] |= value >> (wordBits - shift);
+    }
+
+    //! Creates the leading size and the packed values
+    struct Builder
+    {
+        static constexpr std::size_t numRequiredBytes(std::size_t offset, std::size_t size)
+        {
+            return ArrayBuilder<Word>::numRequiredBytes(offset, 1 + numWords(size));
+        }
+
+        template <class InputIt>
+        static constexpr bool isNothrowBuildable()
+        {
+            if constexpr (std::is_same_v<InputIt, detail::NoIterator> ||
+                          std::is_same_v<InputIt, detail::Zeroed> || isFill<InputIt>::value)
+                return true;
+            else
+                return noexcept(Word(*std::declval<InputIt&>()++));
+        }
+
+        template <class InputIt>
+        std::byte* buildArray(std::byte* buf, Arg<InputIt>& arg)
+        {
+            auto b = reinterpret_cast<Word*>(findNextAlignedPosition(buf, alignof(Word)));
+            auto words = b + 1;
+            auto size = arg.m_size;
+
+            // Zeroed arrays were cleared when the memory was allocated
+            if constexpr (!std::is_same_v<InputIt, detail::Zeroed>)
+                std::fill_n(words, numWords(size), Word(0));
+
+            if constexpr (isFill<InputIt>::value)
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                    insert(words, i, Word(arg.m_it.m_value));
+            }
+            else if constexpr (!std::is_same_v<InputIt, detail::NoIterator> &&
+                               !std::is_same_v<InputIt, detail::Zeroed>)
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                    insert(words, i, Word(*arg.m_it++));
+            }
+
+            b[0] = size;
+            m_begin = b;
+            m_end = words + numWords(size);
+            return reinterpret_cast<std::byte*>(m_end);
+        }
+
+        void release() {}
+
+        Word* m_begin{nullptr};
+        Word* m_end{nullptr};
+    };
+
+    using fc_array_builder = Builder;
+
+    using Handle<Word>::Handle;
+
+    void setLocation(Word* begin, Word* end) { m_begin = begin; }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return m_begin;
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_begin + 1 + numWords(size());
+    }
+
+    std::size_t size() const { return m_begin[0]; }
+
+    value_type get(std::size_t i) const
+    {
+        assert(i < size());
+        return static_cast<value_type>(extract(m_begin + 1, i));
+    }
+
+    void set(std::size_t i, Word value)
+    {
+        assert(i < size());
+        auto words = m_begin + 1;
+        auto bit = i * Bits;
+        words[bit / wordBits] &= ~(mask << (bit % wordBits));
+        if (bit % wordBits + Bits > wordBits)
+            words[bit / wordBits + 1] &= ~(mask >> (wordBits - bit % wordBits));
+        insert(words, i, value);
+    }
+
+    //! Decodes the values from first up to last into "out" and returns the end of the output
+    template <class OutputIt>
+    OutputIt decode(OutputIt out, std::size_t first, std::size_t last) const
+    {
+        assert(first <= last && last <= size());
+        auto words = m_begin + 1;
+
+        for (; first < last && first % wordBits; ++first)
+            *out++ = static_cast<value_type>(extract(words, first));
+        for (; last - first >= wordBits; first += wordBits)
+            out = decodeBlock(words + first / wordBits * Bits, out,
+                              std::make_index_sequence<wordBits>());
+        for (; first < last; ++first)
+            *out++ = static_cast<value_type>(extract(words, first));
+        return out;
+    }
+
+    //! Decodes 64 values, which take "Bits" words
+    template <class OutputIt, std::size_t... I>
+    static OutputIt decodeBlock(const Word* words, OutputIt out, std::index_sequence<I...>)
+    {
+        ((*out++ = static_cast<value_type>(extract(words, I))), ...);
+        return out;
+    }
+
+    Word* m_begin;
+};
+
+/*! Array of arrays of T with different sizes, in a single block
+ *  Created from the number of inner arrays and an iterator over either their
+ *  sizes (default initialized elements) or ranges to copy them from:
+ *
+ *    std::vector<std::vector<int>> adjacency = ...;
+ *    auto p = fc::make<Graph>(fc::arg(adjacency.size(), adjacency.begin()))();
+ *    for (int neighbor : p->edges[3]) ...
+ *
+ *  All elements are stored contiguously, followed by an index with the number
+ *  of inner arrays and the end offset of each one. The iterator is read twice,
+ *  to size the block and then to fill it, so it must be a forward iterator.
+ */
+template <class T, class IndexT = std::uint32_t>
+struct JaggedArray : Handle<T>
+{
+    static_assert(std::is_unsigned_v<IndexT>, "The index must hold unsigned offsets");
+
+    static constexpr std::size_t fc_handle_alignment = std::max(alignof(T), alignof(IndexT));
+    static constexpr bool fc_handle_stores_location = true;
+
+    //! Bytes taken by "numArrays" inner arrays with "numElements" elements in total
+    static constexpr std::size_t numBytes(std::size_t numArrays, std::size_t numElements)
+    {
+        return findNextAlignedPosition(numElements * sizeof(T), alignof(IndexT)) +
+               (1 + numArrays) * sizeof(IndexT);
+    }
+
+    //! The index following the elements that end at "end"
+    static IndexT* index(const T* end)
+    {
+        return reinterpret_cast<IndexT*>(findNextAlignedPosition(end, alignof(IndexT)));
+    }
+
+    //! Number of elements of the inner array described by "inner"
+    template <class Inner>
+    static std::size_t innerSize(const Inner& inner)
+    {
+        if constexpr (std::is_integral_v<Inner>)
+            return inner;
+        else
+            return std::size(inner);
+    }
+
+    //! Creates the elements of all inner arrays, then the index
+    struct Builder
+    {
+        //! Destroys all elements in case they are still being tracked
+        ~Builder()
+        {
+            if (m_begin)
+                reverseDestroy(m_begin, m_end);
+        }
+
+        //! The whole block is sized from the inner sizes, instead of the number of arrays
+        template <class InputIt>
+        static std::size_t layoutSize(const Arg<InputIt>& arg)
+        {
+            static_assert(!std::is_same_v<InputIt, detail::NoIterator> &&
+                              !std::is_same_v<InputIt, detail::Zeroed> &&
+                              !isFill<InputIt>::value,
+                          "A JaggedArray is created from an iterator over the inner arrays");
+
+            std::size_t numElements = 0;
+            auto it = arg.m_it;
+            for (std::size_t i = 0; i < arg.m_size; ++i, ++it)
+                numElements += innerSize(*it);
+            return numBytes(arg.m_size, numElements);
+        }
+
+        static constexpr std::size_t numRequiredBytes(std::size_t offset, std::size_t bytes)
+        {
+            return findNextAlignedPosition(offset, fc_handle_alignment) - offset + bytes;
+        }
+
+        template <class InputIt>
+        static constexpr bool isNothrowBuildable()
+        {
+            return false;
+        }
+
+        template <class InputIt>
+        std::byte* buildArray(std::byte* buf, Arg<InputIt>& arg)
+        {
+            auto b = reinterpret_cast<T*>(findNextAlignedPosition(buf, fc_handle_alignment));
+
+            // The index follows the elements, so their ends are kept until all are created
+            std::vector<IndexT> ends;
+            ends.reserve(arg.m_size);
+
+            // Each element is tracked, in case a constructor throws
+            m_begin = m_end = b;
+            for (std::size_t i = 0; i < arg.m_size; ++i, ++arg.m_it)
+            {
+                auto&& inner = *arg.m_it;
+                if constexpr (std::is_integral_v<remove_cvref_t<decltype(inner)>>)
+                {
+                    for (auto e = m_end + inner; m_end != e; ++m_end)
+                        ::new (m_end) T;
+                }
+                else
+                {
+                    for (auto&& value : inner)
+                    {
+                        ::new (m_end) T(value);
+                        ++m_end;
+                    }
+                }
+                assert(std::size_t(m_end - b) <= std::numeric_limits<IndexT>::max());
+                ends.push_back(IndexT(m_end - b));
+            }
+
+            auto idx = index(m_end);
+            idx[0] = IndexT(arg.m_size);
+            std::copy(ends.begin(), ends.end(), idx + 1);
+            return reinterpret_cast<std::byte*>(idx + 1 + arg.m_size);
+        }
+
+        void release() { m_begin = m_end = nullptr; }
+
+        T* m_begin{nullptr};
+        T* m_end{nullptr};
+    };
+
+    using fc_array_builder = Builder;
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        m_begin = begin;
+        m_end = end;
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return m_begin;
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_end;
+    }
+
+    //! The index ends the storage of the array
+    template <class Base>
+    auto storage_end(const Base* ptr) const
+    {
+        return index(m_end) + 1 + size();
+    }
+
+    //! Number of inner arrays
+    std::size_t size() const { return index(m_end)[0]; }
+
+    //! The i-th inner array
+    span<T> operator[](std::size_t i) const
+    {
+        auto ends = index(m_end) + 1;
+        return {m_begin + (i ? ends[i - 1] : 0), m_begin + ends[i]};
+    }
+
+    //! All elements of all inner arrays
+    span<T> elements() const { return {m_begin, m_end}; }
+
+    T* m_begin;
+    T* m_end;
+};
+
+/*! Arguments of a flexclass created in a NestedArray, see fc::nested
+ *  Both the array arguments and the constructor arguments are copied, so
+ *  that the flexclass can be sized and then created from them.
+ */
+template <class FC, class AArgs, class CArgs>
+struct NestedArg;
+
+template <class FC, class... A, class... ClassArgs>
+struct NestedArg<FC, std::tuple<A...>, std::tuple<ClassArgs...>>
+{
+    //! Layout of the flexclass
+    auto layout() const
+    {
+        return std::apply([](const A&... a) { return computeLayout<FC>(fc::tuple<A...>(a...)); },
+                          m_aArgs);
+    }
+
+    //! Creates the flexclass with "alloc"
+    template <class Alloc>
+    FC* make(Alloc& alloc) const
+    {
+        return std::apply(
+            [&](const A&... a) {
+                fc::tuple<A...> aArgs(a...);
+                auto make = [&](const ClassArgs&... c) {
+                    return makeWithAllocator<FC>(alloc, aArgs, c...);
+                };
+                return std::apply(make, m_cArgs);
+            },
+            m_aArgs);
+    }
+
+    std::tuple<A...> m_aArgs;
+    std::tuple<ClassArgs...> m_cArgs;
+};
+
+/*! Describes a FC to be created in a NestedArray
+ *  Takes the same arguments as fc::make:
+ *
+ *    auto record = fc::nested<Record>(numFields, name.size())(recordId);
+ */
+template <class FC, class... AArgs>
+auto nested(AArgs&&... aArgs)
+{
+    return [a = std::make_tuple(fc::arg(std::forward<AArgs>(aArgs))...)](auto&&... cArgs) {
+        using CArgs = std::tuple<std::decay_t<decltype(cArgs)>...>;
+        return NestedArg<FC, remove_cvref_t<decltype(a)>, CArgs>{
+            a, CArgs(std::forward<decltype(cArgs)>(cArgs)...)};
+    };
+}
+
+/*! Array of flexclasses FC, each one with its own array sizes
+ *  Created from the number of elements and an iterator over their arguments
+ *  (see fc::nested). The elements are created back-to-back in the storage of
+ *  the handle, followed by an index with the offset of each one, so a message
+ *  with any number of variable size records takes a single allocation:
+ *
+ *    struct Message
+ *    {
+ *        auto fc_handles() { return fc::make_tuple(&records); }
+ *        fc::NestedArray<Record> records;
+ *    };
+ *
+ *    std::vector<decltype(fc::nested<Record>(0, 0)(0))> records = ...;
+ *    auto m = fc::make<Message>(fc::arg(records.size(), records.begin()))();
+ *    Record* third = m->records[2];
+ *
+ *  The arguments of all elements have the same type, so they must be created
+ *  from the same kinds of arguments. The elements are destroyed with the array.
+ *  The iterator is read twice, to size the storage and then to fill it, so it
+ *  must be a forward iterator.
+ *  Objects with a NestedArray can't be resized nor relocated.
+ */
+template <class FC, class IndexT = std::uint32_t>
+struct NestedArray : Handle<std::byte>
+{
+    static_assert(std::is_unsigned_v<IndexT>, "The index must hold unsigned offsets");
+
+    static constexpr std::size_t elementAlignment = layoutAlignment<FC>::value;
+    static constexpr std::size_t fc_handle_alignment = std::max(elementAlignment, alignof(IndexT));
+    static constexpr bool fc_handle_stores_location = true;
+
+    //! The index following the elements that end at "end"
+    static IndexT* index(const std::byte* end)
+    {
+        return reinterpret_cast<IndexT*>(findNextAlignedPosition(end, alignof(IndexT)));
+    }
+
+    //! Creates the elements one after the other, then the index
+    struct Builder
+    {
+        //! Destroys all elements in case they are still being tracked
+        ~Builder()
+        {
+            for (auto i = m_offsets.size(); i > 0; --i)
+                destroy_at(reinterpret_cast<FC*>(m_begin + m_offsets[i - 1]));
+        }
+
+        //! Creates an element at "m_buffer", which was sized for it, and records its size
+        struct ElementAllocator
+        {
+            void* allocate(std::size_t sz)
+            {
+                m_size = sz;
+                return m_buffer;
+            }
+
+            void* allocate(std::size_t sz, std::align_val_t) { return allocate(sz); }
+
+            void deallocate(void*) {}
+            void deallocate(void*, std::align_val_t) {}
+
+            std::byte* m_buffer;
+            std::size_t m_size;
+        };
+
+        //! The storage is sized from the layout of each element
+        template <class InputIt>
+        static std::size_t layoutSize(const Arg<InputIt>& arg)
+        {
+            static_assert(!std::is_same_v<InputIt, detail::NoIterator> &&
+                              !std::is_same_v<InputIt, detail::Zeroed> &&
+                              !isFill<InputIt>::value,
+                          "A NestedArray is created from an iterator over fc::nested arguments");
+
+            std::size_t bytes = 0;
+            auto it = arg.m_it;
+            for (std::size_t i = 0; i < arg.m_size; ++i, ++it)
+                bytes = findNextAlignedPosition(bytes, elementAlignment) + (*it).layout().bytes;
+            return findNextAlignedPosition(bytes, alignof(IndexT)) +
+                   (1 + arg.m_size) * sizeof(IndexT);
+        }
+
+        static constexpr std::size_t numRequiredBytes(std::size_t offset, std::size_t bytes)
+        {
+            return findNextAlignedPosition(offset, fc_handle_alignment) - offset + bytes;
+        }
+
+        template <class InputIt>
+        static constexpr bool isNothrowBuildable()
+        {
+            return false;
+        }
+
+        template <class InputIt>
+        std::byte* buildArray(std::byte* buf, Arg<InputIt>& arg)
+        {
+            auto aligned = findNextAlignedPosition(buf, fc_handle_alignment);
+            auto b = reinterpret_cast<std::byte*>(aligned);
+            m_begin = b;
+            m_offsets.reserve(arg.m_size);
+
+            // Each element is created in its own slot, and tracked in case the next one throws.
+            // Its offset is kept until all are created, since the index follows them
+            std::size_t pos = 0;
+            for (std::size_t i = 0; i < arg.m_size; ++i, ++arg.m_it)
+            {
+                pos = findNextAlignedPosition(pos, elementAlignment);
+
+                ElementAllocator alloc{b + pos, 0};
+                auto p = reinterpret_cast<std::byte*>((*arg.m_it).make(alloc));
+                assert(std::size_t(p - b) <= std::numeric_limits<IndexT>::max());
+                m_offsets.push_back(IndexT(p - b));
+                pos += alloc.m_size;
+            }
+            m_end = b + pos;
+
+            auto idx = index(m_end);
+            idx[0] = IndexT(arg.m_size);
+            std::copy(m_offsets.begin(), m_offsets.end(), idx + 1);
+            return reinterpret_cast<std::byte*>(idx + 1 + arg.m_size);
+        }
+
+        void release() { m_offsets.clear(); }
+
+        std::byte* m_begin{nullptr};
+        std::byte* m_end{nullptr};
+        std::vector<IndexT> m_offsets;
+    };
+
+    using fc_array_builder = Builder;
+
+    using Handle<std::byte>::Handle;
+
+    void setLocation(std::byte* begin, std::byte* end)
+    {
+        m_begin = begin;
+        m_end = end;
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return m_begin;
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_end;
+    }
+
+    //! The index ends the storage of the array
+    template <class Base>
+    auto storage_end(const Base* ptr) const
+    {
+        return index(m_end) + 1 + size();
+    }
+
+    //! Destroys the elements in reverse order, along with their own arrays
+    template <class Base>
+    void destroy_elements(const Base* ptr) const
+    {
+        for (auto i = size(); i > 0; --i)
+            destroy_at((*this)[i - 1]);
+    }
+
+    //! Number of elements
+    std::size_t size() const { return index(m_end)[0]; }
+
+    //! The i-th element
+    FC* operator[](std::size_t i) const
+    {
+        return reinterpret_cast<FC*>(m_begin + index(m_end)[1 + i]);
+    }
+
+    std::byte* m_begin;
+    std::byte* m_end;
+};
+
+/*! Like Array, but the first T is aligned to "Align" bytes
+ *  Useful to start numeric arrays on a cache line or on a SIMD
+ *  register boundary. "begin" lets the compiler assume the alignment.
+ */
+template <class T, std::size_t Align>
+struct AlignedArray : Handle<T>
+{
+    static_assert((Align & (Align - 1)) == 0, "Alignment must be a power of two");
+    static_assert(Align >= alignof(T), "Alignment must not be weaker than alignof(T)");
+
+    static constexpr std::size_t fc_handle_alignment = Align;
+    static constexpr bool fc_handle_stores_location = true;
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end) { m_begin = begin; }
+
+    template <class Base = void>
+    auto begin(const Base* ptr = nullptr) const
+    {
+        return assumeAligned<Align>(m_begin);
+    }
+
+    T* m_begin;
+};
+
+/*! Like Range, but the first T is aligned to "Align" bytes
+ */
+template <class T, std::size_t Align>
+struct AlignedRange : Handle<T>
+{
+    static_assert((Align & (Align - 1)) == 0, "Alignment must be a power of two");
+    static_assert(Align >= alignof(T), "Alignment must not be weaker than alignof(T)");
+
+    static constexpr std::size_t fc_handle_alignment = Align;
+    static constexpr bool fc_handle_stores_location = true;
+
+    using Handle<T>::Handle;
+
+    void setLocation(T* begin, T* end)
+    {
+        m_begin = begin;
+        m_end = end;
+    }
+
+    template <class Base>
+    auto begin(const Base* ptr) const
+    {
+        return begin();
+    }
+
+    template <class Base>
+    auto end(const Base* ptr) const
+    {
+        return m_end;
+    }
+
+    auto begin() const { return assumeAligned<Align>(m_begin); }
+    auto end() const { return m_end; }
+
+    T* m_begin;
     T* m_end;
 };
 
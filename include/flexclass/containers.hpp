@@ -0,0 +1,195 @@
+#ifndef FC_FLEXCLASS_CONTAINERS_HPP
+#define FC_FLEXCLASS_CONTAINERS_HPP
+
+#include "core.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace fc
+{
+
+/*! Sequence of FC objects of different sizes stored back-to-back
+ *  Each object (the base followed by its arrays) is carved from segmented
+ *  chunks of an fc::Arena, in insertion order. Iteration steps from each
+ *  object to the next one by its allocation size, and only jumps when a new
+ *  chunk starts, so a linear scan reads memory sequentially instead of
+ *  chasing pointers to separate allocations. Objects never move: a table of
+ *  pointers to them gives stable indices.
+ *
+ *  flex_vector<Node> nodes;
+ *  Node& n = nodes.emplace_back(numLinks)(id);
+ */
+template <class FC>
+class flex_vector
+{
+    //! Objects laid out back-to-back from "m_first"
+    struct Run
+    {
+        FC* m_first;
+        std::size_t m_count;
+    };
+
+    /*! Whether the next object can be found from the size of the previous one
+     *  Otherwise, each object makes a run of its own.
+     */
+    static constexpr bool canStride =
+        knowsAllocationSize<FC>::value && numPrecedingHandles<FC>::value == 0;
+
+    //! Alignment of the allocations made by the arena for a FC (see allocateWithAllocator)
+    static constexpr std::size_t strideAlignment =
+        std::max(layoutAlignment<FC>::value, std::size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+
+    //! Where the object after "p" is, if it was allocated from the same chunk
+    static FC* nextObject(FC* p)
+    {
+        auto bytes = findNextAlignedPosition(allocationSize(p), strideAlignment);
+        return reinterpret_cast<FC*>(reinterpret_cast<std::byte*>(p) + bytes);
+    }
+
+  public:
+    using value_type = FC;
+
+    //! Visits the objects in insertion order, which is also their order in memory
+    class iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FC;
+        using difference_type = std::ptrdiff_t;
+        using pointer = FC*;
+        using reference = FC&;
+
+        iterator(const Run* run, const Run* runEnd) : m_run(run), m_runEnd(runEnd)
+        {
+            enterRun();
+        }
+
+        FC& operator*() const { return *m_pos; }
+        FC* operator->() const { return m_pos; }
+
+        iterator& operator++()
+        {
+            if constexpr (canStride)
+            {
+                if (--m_left)
+                {
+                    m_pos = nextObject(m_pos);
+                    return *this;
+                }
+            }
+            ++m_run;
+            enterRun();
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const iterator& other) const { return m_pos == other.m_pos; }
+        bool operator!=(const iterator& other) const { return m_pos != other.m_pos; }
+
+      private:
+        void enterRun()
+        {
+            auto atEnd = m_run == m_runEnd;
+            m_pos = atEnd ? nullptr : m_run->m_first;
+            m_left = atEnd ? 0 : m_run->m_count;
+        }
+
+        const Run* m_run;
+        const Run* m_runEnd;
+        FC* m_pos;
+        std::size_t m_left;
+    };
+
+    explicit flex_vector(std::size_t firstChunkSize = Arena::defaultChunkSize)
+        : m_arena(firstChunkSize)
+    {
+    }
+
+    flex_vector(flex_vector&&) = default;
+    flex_vector(const flex_vector&) = delete;
+    flex_vector& operator=(const flex_vector&) = delete;
+
+    ~flex_vector() { clear(); }
+
+    //! Appends a FC created from the array arguments "aArgs" and the constructor arguments
+    template <class... AArgs>
+    auto emplace_back(AArgs&&... aArgs)
+    {
+        return [this, a = fc::args(aArgs...)](auto&&... cArgs) mutable -> FC& {
+            // Grow the pointer table first, so the new object is never left untracked
+            m_objects.push_back(nullptr);
+            FC* p = nullptr;
+            try
+            {
+                p = makeWithAllocator<FC>(m_arena, a, std::forward<decltype(cArgs)>(cArgs)...);
+
+                // Extend the last run, unless the object starts a new chunk
+                bool extends = false;
+                if constexpr (canStride)
+                    extends = !m_runs.empty() && p == nextObject(m_objects.end()[-2]);
+                if (!extends)
+                    m_runs.push_back({p, 0});
+                ++m_runs.back().m_count;
+            }
+            catch (...)
+            {
+                if (p)
+                    destroyWithAllocator(m_arena, p);
+                m_objects.pop_back();
+                throw;
+            }
+            return *(m_objects.back() = p);
+        };
+    }
+
+    //! Destroys all objects, keeping the largest chunk for reuse
+    void clear()
+    {
+        if constexpr (!is_trivially_destructible_v<FC>)
+            for (auto it = m_objects.rbegin(); it != m_objects.rend(); ++it)
+                destroyWithAllocator(m_arena, *it);
+        m_objects.clear();
+        m_runs.clear();
+        m_arena.reset();
+    }
+
+    //! Reserves the offset table for "n" objects and the chunk memory for "bytes"
+    void reserve(std::size_t n, std::size_t bytes = 0)
+    {
+        m_objects.reserve(n);
+        if (bytes)
+            m_arena.reserve(bytes);
+    }
+
+    FC& operator[](std::size_t i) const { return *m_objects[i]; }
+    FC& front() const { return *m_objects.front(); }
+    FC& back() const { return *m_objects.back(); }
+
+    iterator begin() const { return iterator(m_runs.data(), m_runs.data() + m_runs.size()); }
+    iterator end() const
+    {
+        auto runEnd = m_runs.data() + m_runs.size();
+        return iterator(runEnd, runEnd);
+    }
+
+    std::size_t size() const { return m_objects.size(); }
+    bool empty() const { return m_objects.empty(); }
+
+  private:
+    Arena m_arena;
+    std::vector<FC*> m_objects;
+    std::vector<Run> m_runs;
+};
+
+} // namespace fc
+
+#endif // FC_FLEXCLASS_CONTAINERS_HPP
@@ -6,9 +6,17 @@
 #include "tuple.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <new>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 namespace fc
 {
@@ -43,8 +51,47 @@ namespace detail
 struct NoIterator
 {
 };
+
+//! Placeholder to indicate all elements are copies of "m_value"
+template <class V>
+struct Fill
+{
+    V m_value;
+};
+
+//! Placeholder to indicate elements are value-initialized from zero-filled memory
+struct Zeroed
+{
+};
 } // namespace detail
 
+/*! Whether the elements referred by an iterator are contiguous in memory
+ *  Arrays of trivially copyable types initialized from such iterators are
+ *  created with a single memcpy.
+ *  Specialize it for other contiguous iterators.
+ */
+template <class It, class V = typename std::iterator_traits<It>::value_type>
+struct isStdContiguousIterator
+    : std::bool_constant<(!std::is_same_v<V, bool> &&
+                          (std::is_same_v<It, typename std::vector<V>::iterator> ||
+                           std::is_same_v<It, typename std::vector<V>::const_iterator>)) ||
+                         std::is_same_v<It, std::string::iterator> ||
+                         std::is_same_v<It, std::string::const_iterator>>
+{
+};
+
+template <class It, class = void>
+struct is_contiguous_iterator : std::is_pointer<It>
+{
+};
+
+template <class It>
+struct is_contiguous_iterator<It,
+                              typename void_<typename std::iterator_traits<It>::value_type>::type>
+    : std::bool_constant<std::is_pointer_v<It> || isStdContiguousIterator<It>::value>
+{
+};
+
 /*! internal
  * Class used to store the arguments for an array creation
  * It stores both the array size and an inputiterator that
@@ -78,6 +125,59 @@ auto arg(Arg<InputIt> a)
     return a;
 }
 
+/*! Array size known at compile time
+ *  Use "fc::static_size<N>" in place of a runtime size. When all arrays of a
+ *  flexclass are created with static sizes, its layout is computed at compile
+ *  time (see fc::static_layout).
+ */
+template <std::size_t N>
+struct StaticSize : std::integral_constant<std::size_t, N>
+{
+};
+
+template <std::size_t N>
+inline constexpr StaticSize<N> static_size{};
+
+//! Arg whose size is the compile time constant N
+template <std::size_t N, class InputIt>
+struct StaticArg : Arg<InputIt>
+{
+    StaticArg() : Arg<InputIt>(N) {}
+    StaticArg(InputIt it) : Arg<InputIt>(N, it) {}
+};
+
+template <std::size_t N>
+auto arg(StaticSize<N>)
+{
+    return StaticArg<N, detail::NoIterator>{};
+}
+
+template <std::size_t N, class InputIt>
+auto arg(StaticSize<N>, InputIt it)
+{
+    return StaticArg<N, InputIt>{it};
+}
+
+template <std::size_t N, class InputIt>
+auto arg(StaticArg<N, InputIt> a)
+{
+    return a;
+}
+
+//! Use this as argument for creating an array where all elements are copies of "value"
+template <class V>
+auto fill(std::size_t size, V value)
+{
+    return Arg<detail::Fill<V>>{size, detail::Fill<V>{std::move(value)}};
+}
+
+/*! Use this as argument for creating an array of zeros
+ *  All zeroed arrays are cleared with a single memset spanning them,
+ *  or not written at all if the allocator provides "allocate_zeroed".
+ *  The element type must be trivial.
+ */
+inline auto zeroed(std::size_t size) { return Arg<detail::Zeroed>{size, detail::Zeroed{}}; }
+
 /*! Placeholder type and values to call ::make to indicate the first
  * argument is an allocator
  */
@@ -87,6 +187,44 @@ struct WithAllocator
 
 static constexpr WithAllocator withAllocator;
 
+template <class InputIt>
+struct isFill : std::false_type
+{
+};
+
+template <class V>
+struct isFill<detail::Fill<V>> : std::true_type
+{
+};
+
+template <class A>
+struct isZeroed : std::false_type
+{
+};
+
+template <>
+struct isZeroed<Arg<detail::Zeroed>> : std::true_type
+{
+};
+
+template <class A>
+struct isStaticArg : std::false_type
+{
+};
+
+template <std::size_t N, class InputIt>
+struct isStaticArg<StaticArg<N, InputIt>> : std::true_type
+{
+};
+
+template <class AArgs>
+struct hasZeroedArg;
+
+template <class... A>
+struct hasZeroedArg<fc::tuple<A...>> : std::bool_constant<(isZeroed<A>::value || ...)>
+{
+};
+
 /*! internal
  *
  * An ArrayBuilder is responsible for two steps of the process
@@ -99,7 +237,7 @@ static constexpr WithAllocator withAllocator;
  * Exceptions are treated with care. If at any point, an exception
  * is thrown, then all objects already created must be destroyed.
  */
-template <class T>
+template <class T, std::size_t Align = alignof(T)>
 struct ArrayBuilder
 {
     //! Destroys all elements in case they are still being tracked
@@ -109,50 +247,119 @@ struct ArrayBuilder
             reverseDestroy(m_begin, m_end);
     }
 
+    //! Whether the array can be initialized in bulk, without tracking each element
+    template <class InputIt>
+    static constexpr bool isBulkInitializable()
+    {
+        if constexpr (std::is_same_v<InputIt, detail::NoIterator>)
+            return std::is_trivially_default_constructible_v<T>;
+        else if constexpr (std::is_same_v<InputIt, detail::Zeroed>)
+            return std::is_trivial_v<T>;
+        else if constexpr (isFill<InputIt>::value)
+            return std::is_trivial_v<T>;
+        else if constexpr (std::is_trivially_copyable_v<T> &&
+                           std::is_same_v<T, remove_cvref_t<decltype(*std::declval<InputIt>())>>)
+            return is_contiguous_iterator<InputIt>::value;
+        else
+            return false;
+    }
+
+    //! Whether creating the array can't throw, so nothing needs to be tracked for a rollback
+    template <class InputIt>
+    static constexpr bool isNothrowBuildable()
+    {
+        if constexpr (isBulkInitializable<InputIt>())
+            return true;
+        else if constexpr (std::is_same_v<InputIt, detail::NoIterator>)
+            return std::is_nothrow_default_constructible_v<T>;
+        else if constexpr (isFill<InputIt>::value)
+            return std::is_nothrow_constructible_v<T, decltype((std::declval<InputIt&>().m_value))>;
+        else
+            return noexcept(T(*std::declval<InputIt&>()++));
+    }
+
     //! Creates the array with inputs specified by Arg in the given buffer.
     template <class InputIt>
     auto buildArray(std::byte* buf, Arg<InputIt>& arg)
     {
         // Find the fist aligned byte suitable for creating T objects
-        auto b = aligner(buf).get<T>();
+        auto b = reinterpret_cast<T*>(findNextAlignedPosition(buf, Align));
         auto e = b + arg.m_size;
 
-        // In case of an exception, ArrayDeleter will make sure
-        //  all objects created up to the point are destroyed
-        //  in reverse order
-        ArrayDeleter<T> deleter(b);
-        for (auto it = b; it != e;)
+        static_assert(!std::is_same_v<InputIt, detail::Zeroed> || std::is_trivial_v<T>,
+                      "fc::zeroed requires a trivial element type");
+
+        if constexpr (isBulkInitializable<InputIt>())
         {
-            // Special handling for default initialization
-            if constexpr (std::is_same_v<InputIt, detail::NoIterator>)
-                new (it) T;
-            else
-                new (it) T(*arg.m_it++);
-            // Tell the ArrayDeleter another element was createdgc
-            deleter.setEnd(++it);
+            // Trivially default constructible elements need no initialization
+            // Zeroed arrays were cleared when the memory was allocated
+            if constexpr (isFill<InputIt>::value)
+                std::fill_n(b, arg.m_size, T(arg.m_it.m_value));
+            else if constexpr (!std::is_same_v<InputIt, detail::NoIterator> &&
+                               !std::is_same_v<InputIt, detail::Zeroed>)
+            {
+                if (arg.m_size)
+                    std::memcpy(b, std::addressof(*arg.m_it), arg.m_size * sizeof(T));
+                std::advance(arg.m_it, arg.m_size);
+            }
         }
+        else if constexpr (isNothrowBuildable<InputIt>())
+        {
+            for (auto it = b; it != e; ++it)
+                constructElement(it, arg);
+        }
+        else
+        {
+            // In case of an exception, ArrayDeleter will make sure
+            //  all objects created up to the point are destroyed
+            //  in reverse order
+            ArrayDeleter<T> deleter(b);
+            for (auto it = b; it != e;)
+            {
+                constructElement(it, arg);
+                // Tell the ArrayDeleter another element was createdgc
+                deleter.setEnd(++it);
+            }
 
-        // No exception was thrown, let the array deleter stop tracking
-        // and the ArrayBuilder will track objects from now on
-        deleter.release();
+            // No exception was thrown, let the array deleter stop tracking
+            // and the ArrayBuilder will track objects from now on
+            deleter.release();
+        }
         m_begin = b;
         m_end = e;
 
         return reinterpret_cast<std::byte*>(e);
     }
 
+    template <class InputIt>
+    static void constructElement(T* it, Arg<InputIt>& arg)
+    {
+        // Special handling for default initialization
+        if constexpr (std::is_same_v<InputIt, detail::NoIterator>)
+            new (it) T;
+        else if constexpr (isFill<InputIt>::value)
+            new (it) T(arg.m_it.m_value);
+        else
+            new (it) T(*arg.m_it++);
+    }
+
     //! Query for the number of bytes necessary to create an T array of size
     //! "sz"
     // "offset" is the offset in an imaginary array starting from 0
-    template <class InputIt>
-    static std::size_t numRequiredBytes(std::size_t offset, const Arg<InputIt>& arg)
+    static constexpr std::size_t numRequiredBytes(std::size_t offset, std::size_t size)
     {
-        auto numBytes = arg.m_size * sizeof(T);
-        auto newOffset = findNextAlignedPosition(offset, alignof(T));
+        auto numBytes = size * sizeof(T);
+        auto newOffset = findNextAlignedPosition(offset, Align);
         newOffset += numBytes;
         return newOffset - offset;
     }
 
+    template <class InputIt>
+    static std::size_t numRequiredBytes(std::size_t offset, const Arg<InputIt>& arg)
+    {
+        return numRequiredBytes(offset, arg.m_size);
+    }
+
     //! Let the array builder stop tracking the array
     void release() { m_begin = m_end = nullptr; }
 
@@ -189,63 +396,793 @@ auto args(Args&&... args)
     return ::fc::make_tuple(fc::arg(std::forward<Args>(args))...);
 }
 
+/*! Alignment of the array of a handle
+ *  Handles may require a stricter alignment than the one of their
+ *  elements by defining "static constexpr std::size_t fc_handle_alignment"
+ */
+template <class H, class = void>
+struct handleAlignment : std::integral_constant<std::size_t, alignof(typename H::fc_handle_type)>
+{
+};
+
+template <class H>
+struct handleAlignment<H, typename void_<decltype(H::fc_handle_alignment)>::type>
+    : std::integral_constant<std::size_t, H::fc_handle_alignment>
+{
+};
+
+/*! Largest number of elements the handle can store the array of
+ *  Handles storing the size in a narrow type (see SizedArray) define
+ *  "static constexpr std::size_t fc_handle_max_size"
+ */
+template <class H, class = void>
+struct handleMaxSize : std::integral_constant<std::size_t, std::size_t(-1)>
+{
+};
+
+template <class H>
+struct handleMaxSize<H, typename void_<decltype(H::fc_handle_max_size)>::type>
+    : std::integral_constant<std::size_t, H::fc_handle_max_size>
+{
+};
+
+/*! Largest byte offset from the base at which the handle can store its array
+ *  Handles storing the location of their array as a narrow offset from the
+ *  handle (see OffsetArray) define "static constexpr std::size_t
+ *  fc_handle_max_offset". The handle is within the base, so its own offset
+ *  to the array is never larger.
+ */
+template <class H, class = void>
+struct handleMaxOffset : std::integral_constant<std::size_t, std::size_t(-1)>
+{
+};
+
+template <class H>
+struct handleMaxOffset<H, typename void_<decltype(H::fc_handle_max_offset)>::type>
+    : std::integral_constant<std::size_t, H::fc_handle_max_offset>
+{
+};
+
+/*! Whether the array of handle H is laid out before the base (see PrecedingArray)
+ *  Such handles define "static constexpr int fc_handle_precedes": the index of
+ *  the handle whose array theirs ends at, or -1 if it ends at the base.
+ */
+template <class H, class = void>
+struct isPreceding : std::false_type
+{
+};
+
+template <class H>
+struct isPreceding<H, typename void_<decltype(H::fc_handle_precedes)>::type> : std::true_type
+{
+};
+
+//! Number of handles of FC whose array precedes the base. They come first in fc_handles()
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct numPrecedingHandles;
+
+template <class FC, class... H>
+struct numPrecedingHandles<FC, fc::tuple<H*...>>
+    : std::integral_constant<int, (int(isPreceding<H>::value) + ... + 0)>
+{
+};
+
+//! Whether the handles of FC whose array precedes the base all come before the other ones
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct precedingHandlesComeFirst;
+
+template <class FC, class... H>
+struct precedingHandlesComeFirst<FC, fc::tuple<H*...>>
+{
+    static constexpr bool compute()
+    {
+        bool preceding[] = {isPreceding<H>::value..., false};
+        for (int i = 0; i < numPrecedingHandles<FC>::value; ++i)
+            if (!preceding[i])
+                return false;
+        return true;
+    }
+
+    static constexpr bool value = compute();
+};
+
+/*! Layout policies, selected by a FC with "using fc_layout_policy = ...;"
+ *  HandleOrder, the default, lays the arrays out in the order of fc_handles().
+ *  SortByAlignment sorts them by decreasing alignment, which removes most of
+ *  the padding between arrays of mixed element types.
+ */
+struct HandleOrder
+{
+};
+
+struct SortByAlignment
+{
+};
+
+template <class FC, class = void>
+struct layoutPolicy
+{
+    using type = HandleOrder;
+};
+
+template <class FC>
+struct layoutPolicy<FC, typename void_<typename FC::fc_layout_policy>::type>
+{
+    using type = typename FC::fc_layout_policy;
+};
+
+/*! Whether handle H stores the location of its array (e.g. Range), so that
+ *  the array can be placed anywhere. Such handles define
+ *  "static constexpr bool fc_handle_stores_location = true".
+ */
+template <class H, class = void>
+struct storesLocation : std::false_type
+{
+};
+
+template <class H>
+struct storesLocation<H, typename void_<decltype(H::fc_handle_stores_location)>::type>
+    : std::bool_constant<H::fc_handle_stores_location>
+{
+};
+
+/*! Order of the arrays of FC in memory, as indices into fc_handles()
+ *  Preceding arrays always come first. With SortByAlignment, the following
+ *  arrays are grouped into chains: each handle that stores its location
+ *  starts one, and the handles after it that don't (e.g. AdjacentArray) are
+ *  kept right behind it. The chains are then sorted by decreasing alignment
+ *  of their first array, except the one right after the base.
+ */
+template <class FC, class Policy = typename layoutPolicy<FC>::type,
+          class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct layoutOrder;
+
+template <class FC, class Policy, class... H>
+struct layoutOrder<FC, Policy, fc::tuple<H*...>>
+{
+    static constexpr int numArrays = sizeof...(H);
+
+    static constexpr auto compute()
+    {
+        std::array<int, numArrays> order{};
+        for (int i = 0; i < numArrays; ++i)
+            order[i] = i;
+
+        if constexpr (numArrays > 0 && std::is_same_v<Policy, SortByAlignment>)
+        {
+            constexpr bool stores[] = {storesLocation<H>::value...};
+            constexpr std::size_t alignments[] = {handleAlignment<H>::value...};
+            constexpr int first = numPrecedingHandles<FC>::value;
+
+            // First array of the chain of each array, -1 for the chain after the base
+            std::array<int, numArrays> chains{};
+            for (int i = first, chain = -1; i < numArrays; ++i)
+                chains[i] = chain = stores[i] ? i : chain;
+
+            int pos = first;
+            auto appendChain = [&](int chain) {
+                for (int i = first; i < numArrays; ++i)
+                    if (chains[i] == chain)
+                        order[pos++] = i;
+            };
+
+            appendChain(-1);
+            std::array<bool, numArrays> placed{};
+            for (;;)
+            {
+                int next = -1;
+                for (int i = first; i < numArrays; ++i)
+                    if (stores[i] && !placed[i] &&
+                        (next == -1 || alignments[i] > alignments[next]))
+                        next = i;
+                if (next == -1)
+                    break;
+                placed[next] = true;
+                appendChain(next);
+            }
+        }
+        return order;
+    }
+
+    static constexpr auto value = compute();
+};
+
+template <class FC, class Policy, class Fn, class... H, std::size_t... K>
+constexpr void forEachInLayoutOrder(Fn&& fn, fc::tuple<H*...>*, std::index_sequence<K...>)
+{
+    [[maybe_unused]] constexpr auto order = layoutOrder<FC, Policy>::value;
+    (fn(static_cast<TypeAtIdx<order[K], H*...>*>(nullptr),
+        std::integral_constant<int, order[K]>()),
+     ...);
+}
+
+//! Like for_each_constexpr on the handles of FC, but in the order of their arrays in memory
+template <class FC, class Policy = typename layoutPolicy<FC>::type, class Fn>
+constexpr void forEachInLayoutOrder(Fn&& fn)
+{
+    using Handles = decltype(std::declval<FC&>().fc_handles());
+    forEachInLayoutOrder<FC, Policy>(fn, static_cast<Handles*>(nullptr),
+                                     std::make_index_sequence<Handles::Size>());
+}
+
+/*! The ArrayBuilder that creates the array of handle H
+ *  Handles whose storage is not a plain array of fc_handle_type (e.g. SoA)
+ *  provide their own builder with "using fc_array_builder = ...". It has the
+ *  same interface as ArrayBuilder, with begin and end in "m_begin" and "m_end"
+ *  for setLocation, and must leave nothing to destroy but fc_handle_type objects,
+ *  unless the handle destroys them itself with "destroy_elements" (see NestedArray).
+ */
+template <class H, class = void>
+struct arrayBuilderOf
+{
+    using type = ArrayBuilder<typename H::fc_handle_type, handleAlignment<H>::value>;
+};
+
+template <class H>
+struct arrayBuilderOf<H, typename void_<typename H::fc_array_builder>::type>
+{
+    using type = typename H::fc_array_builder;
+};
+
+template <class H>
+using ArrayBuilderFor = typename arrayBuilderOf<H>::type;
+
+//! Whether the array of handle H is an array of fc_handle_type built by ArrayBuilder
+template <class H>
+struct hasPlainArray
+    : std::is_same<ArrayBuilderFor<H>,
+                   ArrayBuilder<typename H::fc_handle_type, handleAlignment<H>::value>>
+{
+};
+
 template <class Handles>
 struct Handles2ArrayBuilders;
 
 template <class... T>
 struct Handles2ArrayBuilders<fc::tuple<T*...>>
 {
-    using type = fc::tuple<ArrayBuilder<typename T::fc_handle_type>...>;
+    using type = fc::tuple<ArrayBuilderFor<T>...>;
 };
 
-template <class FC, class Alloc, class AArgs, class... ClassArgs>
-auto makeWithAllocator(Alloc& alloc, AArgs&& aArgs, ClassArgs&&... cArgs)
+/*! Whether "handle->destroy_elements(base)" is available: the handle destroys
+ *  the objects in its storage itself, instead of the library destroying its
+ *  elements as fc_handle_type objects (see NestedArray)
+ */
+template <class Handle, class Base, class = void>
+struct hasDestroyElements : std::false_type
 {
-    using Handles = decltype(std::declval<FC>().fc_handles());
+};
+
+template <class Handle, class Base>
+struct hasDestroyElements<Handle, Base,
+                          typename void_<decltype(std::declval<const Handle&>().destroy_elements(
+                              std::declval<const Base*>()))>::type> : std::true_type
+{
+};
+
+/*! Whether destroying a FC is a no-op
+ *  That is the case when both FC and the elements of all its arrays are
+ *  trivially destructible. Such objects can be abandoned in an fc::Arena
+ *  and reclaimed in bulk with Arena::reset.
+ */
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct is_trivially_destructible;
+
+template <class FC, class... H>
+struct is_trivially_destructible<FC, fc::tuple<H*...>>
+    : std::bool_constant<std::is_trivially_destructible_v<FC> &&
+                         ((std::is_trivially_destructible_v<typename H::fc_handle_type> &&
+                           !hasDestroyElements<H, FC>::value) &&
+                          ...)>
+{
+};
+
+template <class FC>
+inline constexpr bool is_trivially_destructible_v = is_trivially_destructible<FC>::value;
+
+//! Whether "handle->end(base)" is available
+template <class Handle, class Base, class = void>
+struct hasEnd : std::false_type
+{
+};
+
+template <class Handle, class Base>
+struct hasEnd<Handle, Base,
+              typename void_<decltype(std::declval<const Handle&>().end(
+                  std::declval<const Base*>()))>::type> : std::true_type
+{
+};
+
+//! Whether "handle->capacity_end(base)" is available: the handle keeps room past its end
+template <class Handle, class Base, class = void>
+struct hasCapacityEnd : std::false_type
+{
+};
+
+template <class Handle, class Base>
+struct hasCapacityEnd<Handle, Base,
+                      typename void_<decltype(std::declval<const Handle&>().capacity_end(
+                          std::declval<const Base*>()))>::type> : std::true_type
+{
+};
+
+/*! Whether "handle->storage_end(base)" is available: the handle keeps trivially
+ *  copyable data past the end of its elements (see JaggedArray)
+ */
+template <class Handle, class Base, class = void>
+struct hasStorageEnd : std::false_type
+{
+};
+
+template <class Handle, class Base>
+struct hasStorageEnd<Handle, Base,
+                     typename void_<decltype(std::declval<const Handle&>().storage_end(
+                         std::declval<const Base*>()))>::type> : std::true_type
+{
+};
+
+/*! End of the storage reserved for the array of "handle"
+ *  That is its end, unless the handle keeps room for more elements (see GrowableRange)
+ *  or more data after them (see JaggedArray)
+ */
+template <class Handle, class Base>
+auto storageEnd(const Handle& handle, const Base* base)
+{
+    if constexpr (hasStorageEnd<Handle, Base>::value)
+        return handle.storage_end(base);
+    else if constexpr (hasCapacityEnd<Handle, Base>::value)
+        return handle.capacity_end(base);
+    else
+        return handle.end(base);
+}
+
+/*! Whether the number of bytes allocated for a FC can be derived from
+ *  its handles. The last array in the layout ends the allocation, so
+ *  that requires its handle to provide "end" (e.g. Range or AdjacentRange).
+ */
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct knowsAllocationSize;
+
+template <class FC>
+struct knowsAllocationSize<FC, fc::tuple<>> : std::true_type
+{
+};
+
+template <class FC, class... H>
+struct knowsAllocationSize<FC, fc::tuple<H*...>>
+    : hasEnd<std::remove_pointer_t<
+                 TypeAtIdx<layoutOrder<FC>::value[sizeof...(H) - 1], H*...>>,
+             FC>
+{
+};
+
+/*! Alignment of the allocation of a FC
+ *  The base is aligned to the strictest alignment among FC and the elements
+ *  of its arrays, so that the offsets of the arrays computed from 0 match
+ *  the actual addresses.
+ */
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct layoutAlignment;
+
+template <class FC, class... H>
+struct layoutAlignment<FC, fc::tuple<H*...>>
+    : std::integral_constant<std::size_t,
+                             std::max({alignof(FC), handleAlignment<H>::value...})>
+{
+};
+
+//! Whether the builder of handle H computes the size of its array from the whole argument A
+template <class H, class A, class = void>
+struct hasLayoutSize : std::false_type
+{
+};
+
+template <class H, class A>
+struct hasLayoutSize<H, A,
+                     typename void_<decltype(ArrayBuilderFor<H>::layoutSize(
+                         std::declval<const A&>()))>::type> : std::true_type
+{
+};
+
+//! Whether the builder of any handle of FC computes the size of its array from its argument
+template <class FC, class AArgs, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct anyHasLayoutSize : std::false_type
+{
+};
+
+template <class FC, class... A, class... H>
+struct anyHasLayoutSize<FC, fc::tuple<A...>, fc::tuple<H*...>>
+{
+    static constexpr bool compute()
+    {
+        if constexpr (sizeof...(A) == sizeof...(H))
+            return (hasLayoutSize<H, A>::value || ...);
+        else
+            return false;
+    }
+
+    static constexpr bool value = compute();
+};
+
+template <class FC, std::size_t... N>
+struct static_layout;
+
+//! The static_layout of FC created from AArgs, if all of them have static sizes
+template <class FC, class AArgs>
+struct staticLayoutFor
+{
+};
+
+template <class FC, std::size_t... N, class... InputIt>
+struct staticLayoutFor<FC, fc::tuple<StaticArg<N, InputIt>...>>
+{
+    using type = static_layout<FC, N...>;
+};
+
+template <class FC, class AArgs, class = void>
+struct hasStaticLayout : std::false_type
+{
+};
+
+//! Static sizes are not enough for builders that size their array from the whole argument
+template <class FC, class AArgs>
+struct hasStaticLayout<FC, AArgs, typename void_<typename staticLayoutFor<FC, AArgs>::type>::type>
+    : std::bool_constant<!anyHasLayoutSize<FC, AArgs>::value>
+{
+};
+
+/*! Byte layout of a flexclass with NumArrays arrays
+ *  "bytes" is the size of the allocation, "alignment" the alignment it requires
+ *  and "offsets[I]" the byte offset of the I-th array from the start of the
+ *  allocation. The base is at "baseOffset", which is 0 unless some arrays
+ *  precede it (see PrecedingArray).
+ */
+template <std::size_t NumArrays>
+struct Layout
+{
+    std::size_t bytes;
+    std::size_t alignment;
+    std::array<std::size_t, NumArrays> offsets;
+    std::size_t baseOffset;
+    //! Bytes saved by the layout policy of the FC (see SortByAlignment), as reported by layout_of
+    std::ptrdiff_t paddingSaved;
+};
+
+/*! Computes the layout of a FC whose arrays have "sizes" elements
+ *  Throws std::length_error if a handle can't store the size or the offset
+ *  of its array
+ */
+template <class FC, class Policy = typename layoutPolicy<FC>::type, std::size_t NumArrays>
+constexpr auto layoutFromSizes(const std::array<std::size_t, NumArrays>& sizes)
+{
+    using Handles = decltype(std::declval<FC&>().fc_handles());
+    static_assert(NumArrays == Handles::Size, "A size is required for each array of FC");
+    static_assert(precedingHandlesComeFirst<FC>::value,
+                  "Preceding arrays come first in fc_handles(), before all other arrays");
+
+    // Arrays after the base are placed from the base upwards, and arrays
+    // preceding it from the base downwards. "below" is the extent of the latter
+    Layout<NumArrays> layout{sizeof(FC), layoutAlignment<FC>::value, {}, 0, 0};
+    std::size_t below = 0;
+    forEachInLayoutOrder<FC, Policy>([&](auto* type, auto idx) {
+        using Element = remove_cvref_t<decltype(**type)>;
+        using Idx = decltype(idx);
+
+        if constexpr (isPreceding<Element>::value)
+        {
+            auto numBytes = sizes[Idx::value] * sizeof(typename Element::fc_handle_type);
+            static_assert(Element::fc_handle_precedes == Idx::value - 1,
+                          "Preceding arrays come first in fc_handles(), each one "
+                          "preceding the previous one (or the base for the first one)");
+            below = findNextAlignedPosition(below, handleAlignment<Element>::value) + numBytes;
+            layout.offsets[Idx::value] = below;
+        }
+        else
+        {
+            auto offset = findNextAlignedPosition(layout.bytes, handleAlignment<Element>::value);
+            layout.bytes += ArrayBuilderFor<Element>::numRequiredBytes(layout.bytes,
+                                                                       sizes[Idx::value]);
+            layout.offsets[Idx::value] = offset;
+        }
+    });
 
-    std::size_t numBytesForArrays = 0;
+    // The base stays aligned for the whole layout
+    layout.baseOffset = findNextAlignedPosition(below, layout.alignment);
+    layout.bytes += layout.baseOffset;
     for_each_constexpr<Handles>([&](auto* type, auto idx) {
         using Element = remove_cvref_t<decltype(**type)>;
         using Idx = decltype(idx);
-        using T = typename Element::fc_handle_type;
 
-        ArrayBuilder<T> arrBuilder;
+        if constexpr (isPreceding<Element>::value)
+            layout.offsets[Idx::value] = layout.baseOffset - layout.offsets[Idx::value];
+        else
+            layout.offsets[Idx::value] += layout.baseOffset;
+
+        // Checked before anything is allocated, the handle couldn't store it
+        if (sizes[Idx::value] > handleMaxSize<Element>::value)
+            throw std::length_error("fc: array too large for its handle");
+        if constexpr (!isPreceding<Element>::value)
+            if (layout.offsets[Idx::value] - layout.baseOffset > handleMaxOffset<Element>::value)
+                throw std::length_error("fc: array too far from its handle");
+    });
+    return layout;
+}
+
+/*! Layout of a FC whose arrays have the compile time sizes N...
+ *  "offsets[I]" is the byte offset of the I-th array from the start of the
+ *  allocation, and "bytes" the size of the whole allocation. Useful to size
+ *  static pools:
+ *
+ *    alignas(fc::static_layout<Node, 16, 4>::alignment)
+ *        std::byte buffer[fc::static_layout<Node, 16, 4>::bytes];
+ */
+template <class FC, std::size_t... N>
+struct static_layout
+{
+    static constexpr auto layout =
+        layoutFromSizes<FC>(std::array<std::size_t, sizeof...(N)>{N...});
+
+    static constexpr auto offsets = layout.offsets;
+    static constexpr std::size_t bytes = layout.bytes;
+    static constexpr std::size_t alignment = layout.alignment;
+    static constexpr std::size_t baseOffset = layout.baseOffset;
+};
+
+/*! Size of the array of handle H created from "arg", as passed to numRequiredBytes
+ *  That is its number of elements, unless the builder provides
+ *  "static std::size_t layoutSize(const Arg<InputIt>&)" (see JaggedArray)
+ */
+template <class H, class A>
+std::size_t layoutSize(const A& arg)
+{
+    if constexpr (hasLayoutSize<H, A>::value)
+        return ArrayBuilderFor<H>::layoutSize(arg);
+    else
+        return arg.m_size;
+}
 
-        numBytesForArrays += arrBuilder.numRequiredBytes(sizeof(FC) + numBytesForArrays,
-                                                         aArgs.template get<Idx::value>());
+//! Size of each array of FC created from the array arguments in "aArgs"
+template <class FC, class... A>
+auto arraySizes(const fc::tuple<A...>& aArgs)
+{
+    using Handles = decltype(std::declval<FC&>().fc_handles());
+    std::array<std::size_t, sizeof...(A)> sizes{};
+    for_each_in_tuple(aArgs, [&](auto& arg, auto idx) {
+        using Idx = decltype(idx);
+        using Handle =
+            remove_cvref_t<decltype(*std::declval<Handles&>().template get<Idx::value>())>;
+        sizes[idx] = layoutSize<Handle>(arg);
     });
+    return sizes;
+}
+
+//! Computes the layout of a FC created from the array arguments in "aArgs"
+template <class FC, class AArgs>
+auto computeLayout(const AArgs& aArgs)
+{
+    // All sizes are known at compile time
+    if constexpr (hasStaticLayout<FC, AArgs>::value)
+        return staticLayoutFor<FC, AArgs>::type::layout;
+    else
+        return layoutFromSizes<FC>(arraySizes<FC>(aArgs));
+}
+
+/*! Layout of a FC created with the given array arguments, without creating it
+ *  Takes the same array arguments as fc::make. "paddingSaved" reports the
+ *  bytes saved by the layout policy of FC. For example, to reserve the
+ *  memory of many objects at once:
+ *
+ *    auto layout = fc::layout_of<Node>(numLinks, numWeights);
+ */
+template <class FC, class... AArgs>
+auto layout_of(AArgs&&... aArgs)
+{
+    auto args = fc::args(std::forward<AArgs>(aArgs)...);
+    auto layout = computeLayout<FC>(args);
+
+    // Compare with the arrays laid out in the order of fc_handles()
+    if constexpr (!std::is_same_v<typename layoutPolicy<FC>::type, HandleOrder>)
+    {
+        auto inHandleOrder = layoutFromSizes<FC, HandleOrder>(arraySizes<FC>(args));
+        layout.paddingSaved = std::ptrdiff_t(inHandleOrder.bytes) - std::ptrdiff_t(layout.bytes);
+    }
+    return layout;
+}
+
+/*! Location of an array of T placed right after the base
+ *  The base is aligned for the whole layout, so it is a constant offset
+ */
+template <class T, class Base>
+T* adjacentBegin(const Base* ptr)
+{
+    constexpr auto offset = findNextAlignedPosition(sizeof(Base), alignof(T));
+    return reinterpret_cast<T*>(
+        const_cast<std::byte*>(reinterpret_cast<const std::byte*>(ptr) + offset));
+}
+
+/*! Start of the allocation of "p"
+ *  That is the base itself, unless arrays precede it: the allocation then
+ *  starts below the furthest one, at the alignment of the layout.
+ */
+template <class FC>
+std::byte* allocationBegin(FC* p)
+{
+    static_assert(precedingHandlesComeFirst<FC>::value,
+                  "Preceding arrays come first in fc_handles(), before all other arrays");
+    auto base = reinterpret_cast<std::byte*>(p);
+    constexpr auto numPreceding = numPrecedingHandles<FC>::value;
+    if constexpr (numPreceding == 0)
+        return base;
+    else
+    {
+        auto first = p->fc_handles().template get<numPreceding - 1>()->begin(p);
+        std::size_t below = base - reinterpret_cast<std::byte*>(first);
+        return base - findNextAlignedPosition(below, layoutAlignment<FC>::value);
+    }
+}
 
-    auto memBuffer = unique_ptr_impl<void, DeleteFn<FC, Alloc>>(
-        alloc.allocate(sizeof(FC) + numBytesForArrays), alloc);
+//! Number of bytes allocated for "p". Requires knowsAllocationSize<FC>
+template <class FC>
+std::size_t allocationSize(FC* p)
+{
+    auto&& handles = p->fc_handles();
+    constexpr auto numHandles = remove_cvref_t<decltype(handles)>::Size;
+    const std::byte* end;
+    if constexpr (numHandles == numPrecedingHandles<FC>::value)
+        end = reinterpret_cast<const std::byte*>(p + 1);
+    else
+    {
+        constexpr auto last = layoutOrder<FC>::value[numHandles - 1];
+        end = reinterpret_cast<const std::byte*>(storageEnd(*handles.template get<last>(), p));
+    }
+    return end - allocationBegin(p);
+}
+
+//! Number of bytes allocated for a live FC. Requires the last handle to provide "end"
+template <class FC>
+std::size_t allocated_size(const FC* p)
+{
+    static_assert(knowsAllocationSize<FC>::value,
+                  "The allocation size is only known if the last handle provides end()");
+    return allocationSize(const_cast<FC*>(p));
+}
 
-    FC* ret;
+//! Creates the base object in "mem"
+template <class FC, class... ClassArgs>
+FC* constructBase(void* mem, ClassArgs&&... cArgs)
+{
     if constexpr (std::is_aggregate_v<FC>)
-        ret = new (memBuffer.get()) FC{std::forward<ClassArgs>(cArgs)...};
+        return new (mem) FC{std::forward<ClassArgs>(cArgs)...};
     else
-        ret = new (memBuffer.get()) FC(std::forward<ClassArgs>(cArgs)...);
+        return new (mem) FC(std::forward<ClassArgs>(cArgs)...);
+}
 
-    memBuffer.get_deleter().m_objectCreated = true;
+/*! Whether a FC can be created from array arguments AArgs and constructor
+ *  arguments ClassArgs without throwing (not considering the allocation)
+ */
+template <class FC, class AArgs, class... ClassArgs>
+struct isNothrowMakeable;
 
-    // Start creating arrays right after the FC object
-    std::byte* arrayBuffer = reinterpret_cast<std::byte*>(ret + 1);
+template <class FC, class... A, class... ClassArgs>
+struct isNothrowMakeable<FC, fc::tuple<A...>, ClassArgs...>
+{
+    template <class Builder, class InputIt>
+    static constexpr bool isNothrowBuildable(Builder*, Arg<InputIt>*)
+    {
+        return Builder::template isNothrowBuildable<InputIt>();
+    }
 
-    using ArrayBuilders = typename Handles2ArrayBuilders<Handles>::type;
-    ArrayBuilders arrayBuilders;
+    template <class... H>
+    static constexpr bool arraysAreNothrow(fc::tuple<H*...>*)
+    {
+        return (isNothrowBuildable(static_cast<ArrayBuilderFor<H>*>(nullptr),
+                                   static_cast<A*>(nullptr)) &&
+                ...);
+    }
 
-    for_each_in_tuple(arrayBuilders, [&](auto& arrayBuilder, auto idx) mutable {
-        using Idx = decltype(idx);
-        arrayBuffer = arrayBuilder.buildArray(arrayBuffer, aArgs.template get<Idx::value>());
-    });
+    static constexpr bool baseIsNothrow()
+    {
+        if constexpr (std::is_aggregate_v<FC>)
+            return noexcept(::new (std::declval<void*>()) FC{std::declval<ClassArgs>()...});
+        else
+            return std::is_nothrow_constructible_v<FC, ClassArgs...>;
+    }
+
+    using Handles = decltype(std::declval<FC&>().fc_handles());
+
+    static constexpr bool value =
+        baseIsNothrow() && arraysAreNothrow(static_cast<Handles*>(nullptr));
+};
+
+template <class FC, class Alloc, class AArgs, class... ClassArgs>
+auto makeWithAllocator(Alloc& alloc, AArgs&& aArgs, ClassArgs&&... cArgs)
+{
+    using Handles = decltype(std::declval<FC>().fc_handles());
 
-    auto&& handles = ret->fc_handles();
-    for_each_in_tuple(arrayBuilders, [&](auto& arrayBuilder, auto idx) mutable {
+    auto layout = computeLayout<FC>(aArgs);
+
+    // Byte range covering all arrays created with fc::zeroed
+    std::size_t zeroedBegin = std::size_t(-1), zeroedEnd = 0;
+    for_each_constexpr<Handles>([&](auto* type, auto idx) {
+        using Element = remove_cvref_t<decltype(**type)>;
         using Idx = decltype(idx);
-        handles.template get<Idx::value>()->setLocation(arrayBuilder.m_begin, arrayBuilder.m_end);
-        arrayBuilder.release();
+
+        auto& arg = aArgs.template get<Idx::value>();
+        if constexpr (isZeroed<remove_cvref_t<decltype(arg)>>::value)
+        {
+            auto offset = layout.offsets[Idx::value];
+            auto numBytes =
+                ArrayBuilderFor<Element>::numRequiredBytes(offset, layoutSize<Element>(arg));
+            zeroedBegin = std::min(zeroedBegin, offset);
+            zeroedEnd = std::max(zeroedEnd, offset + numBytes);
+        }
     });
 
-    memBuffer.release();
-    return ret;
+    constexpr auto alignment = layoutAlignment<FC>::value;
+    constexpr auto anyZeroed = hasZeroedArg<remove_cvref_t<AArgs>>::value;
+    constexpr auto zeroedMemory = anyZeroed && hasZeroedAllocate<alignment, Alloc>;
+
+    auto size = layout.bytes;
+    void* mem;
+    if constexpr (zeroedMemory)
+        mem = allocateZeroedWithAllocator<alignment>(alloc, size);
+    else
+        mem = allocateWithAllocator<alignment>(alloc, size);
+
+    // Clear all zeroed arrays at once. Other arrays in between will be
+    // constructed on top of the zeros
+    if constexpr (anyZeroed && !zeroedMemory)
+        if (zeroedBegin < zeroedEnd)
+            std::memset(static_cast<std::byte*>(mem) + zeroedBegin, 0, zeroedEnd - zeroedBegin);
+
+    // Nothing can throw past the allocation: build each array and
+    // inform its handle right away, without any rollback bookkeeping
+    auto bytes = static_cast<std::byte*>(mem);
+    if constexpr (isNothrowMakeable<FC, remove_cvref_t<AArgs>, ClassArgs&&...>::value)
+    {
+        auto ret = constructBase<FC>(bytes + layout.baseOffset, std::forward<ClassArgs>(cArgs)...);
+
+        auto&& handles = ret->fc_handles();
+        for_each_in_tuple(handles, [&](auto* handle, auto idx) {
+            using Idx = decltype(idx);
+            ArrayBuilderFor<remove_cvref_t<decltype(*handle)>> arrayBuilder;
+            arrayBuilder.buildArray(bytes + layout.offsets[Idx::value],
+                                    aArgs.template get<Idx::value>());
+            handle->setLocation(arrayBuilder.m_begin, arrayBuilder.m_end);
+            arrayBuilder.release();
+        });
+        return ret;
+    }
+    else
+    {
+        using Deleter = DeleteFn<FC, Alloc, alignment>;
+        auto memBuffer = unique_ptr_impl<void, Deleter>(mem, Deleter(alloc, size));
+
+        FC* ret = constructBase<FC>(bytes + layout.baseOffset, std::forward<ClassArgs>(cArgs)...);
+
+        memBuffer.get_deleter().m_objectCreated = true;
+        memBuffer.get_deleter().m_baseOffset = layout.baseOffset;
+
+        using ArrayBuilders = typename Handles2ArrayBuilders<Handles>::type;
+        ArrayBuilders arrayBuilders;
+
+        for_each_in_tuple(arrayBuilders, [&](auto& arrayBuilder, auto idx) mutable {
+            using Idx = decltype(idx);
+            arrayBuilder.buildArray(bytes + layout.offsets[Idx::value],
+                                    aArgs.template get<Idx::value>());
+        });
+
+        auto&& handles = ret->fc_handles();
+        for_each_in_tuple(arrayBuilders, [&](auto& arrayBuilder, auto idx) mutable {
+            using Idx = decltype(idx);
+            handles.template get<Idx::value>()->setLocation(arrayBuilder.m_begin,
+                                                            arrayBuilder.m_end);
+            arrayBuilder.release();
+        });
+
+        memBuffer.release();
+        return ret;
+    }
 }
 
 template <class FC, class Alloc>
@@ -256,13 +1193,29 @@ void destroyWithAllocator(Alloc& alloc, FC* p)
     auto&& handles = p->fc_handles();
     reverse_for_each_in_tuple(handles, [p](auto* handle, auto idx) {
         using Handle = remove_cvref_t<decltype(*handle)>;
-        if constexpr (!std::is_trivially_destructible<typename Handle::fc_handle_type>::value)
+        if constexpr (hasDestroyElements<Handle, FC>::value)
+        {
+            handle->destroy_elements(p);
+        }
+        else if constexpr (!std::is_trivially_destructible<typename Handle::fc_handle_type>::value)
         {
             reverseDestroy(handle->begin(p), handle->end(p));
         }
     });
-    p->~FC();
-    alloc.deallocate(const_cast<FC*>(p));
+
+    constexpr auto alignment = layoutAlignment<FC>::value;
+    auto mem = allocationBegin(p);
+    if constexpr (knowsAllocationSize<FC>::value)
+    {
+        auto size = allocationSize(p);
+        p->~FC();
+        deallocateWithAllocator<alignment>(alloc, mem, size);
+    }
+    else
+    {
+        p->~FC();
+        deallocateWithAllocator<alignment>(alloc, mem);
+    }
 }
 
 template <class FC, class AArgs, class... ClassArgs>
@@ -302,6 +1255,180 @@ auto make(WithAllocator, Alloc& alloc, AArgs&&... aArgs)
     };
 }
 
+/*! Creates a FC in the caller-provided buffer "buf" of "cap" bytes
+ *  The object is placed at the first position of "buf" aligned for it, and
+ *  std::bad_alloc is thrown if it doesn't fit (see fc::layout_of).
+ *  Destroy it with fc::destroy_at, which leaves the buffer to the caller.
+ */
+template <class FC, class... AArgs>
+auto make_at(void* buf, std::size_t cap, AArgs&&... aArgs)
+{
+    return [a = fc::args(aArgs...), buf, cap](auto&&... cArgs) mutable {
+        BufferAllocator<layoutAlignment<FC>::value> alloc{buf, cap};
+        return fc::makeWithAllocator<FC>(alloc, a, std::forward<decltype(cArgs)>(cArgs)...);
+    };
+}
+
+//! Destroys a FC created with fc::make_at without releasing its memory
+template <class FC>
+void destroy_at(FC* ptr)
+{
+    BufferAllocator<layoutAlignment<FC>::value> alloc{nullptr, 0};
+    destroyWithAllocator<FC>(alloc, ptr);
+}
+
+/*! View over "count" FC objects laid out back-to-back in a single allocation
+ *  Objects are "stride" bytes apart: the size of the layout rounded up to its
+ *  alignment. Each base is "baseOffset" bytes into its layout (see Layout).
+ *  Created by fc::make_n and released with fc::destroy_n.
+ */
+template <class FC>
+class batch
+{
+  public:
+    class iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FC;
+        using difference_type = std::ptrdiff_t;
+        using pointer = FC*;
+        using reference = FC&;
+
+        iterator(std::byte* pos, std::size_t stride) : m_pos(pos), m_stride(stride) {}
+
+        FC& operator*() const { return *reinterpret_cast<FC*>(m_pos); }
+        FC* operator->() const { return reinterpret_cast<FC*>(m_pos); }
+
+        iterator& operator++()
+        {
+            m_pos += m_stride;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto prev = *this;
+            m_pos += m_stride;
+            return prev;
+        }
+
+        bool operator==(const iterator& other) const { return m_pos == other.m_pos; }
+        bool operator!=(const iterator& other) const { return m_pos != other.m_pos; }
+
+      private:
+        std::byte* m_pos;
+        std::size_t m_stride;
+    };
+
+    batch(std::byte* data, std::size_t count, std::size_t stride, std::size_t baseOffset = 0)
+        : m_data(data), m_count(count), m_stride(stride), m_baseOffset(baseOffset)
+    {
+    }
+
+    iterator begin() const { return iterator(m_data + m_baseOffset, m_stride); }
+    iterator end() const { return iterator(m_data + m_baseOffset + m_count * m_stride, m_stride); }
+
+    FC& operator[](std::size_t i) const
+    {
+        return *reinterpret_cast<FC*>(m_data + m_baseOffset + i * m_stride);
+    }
+
+    std::size_t size() const { return m_count; }
+    std::size_t stride() const { return m_stride; }
+
+    //! The allocation holding all objects
+    std::byte* data() const { return m_data; }
+
+  private:
+    std::byte* m_data;
+    std::size_t m_count;
+    std::size_t m_stride;
+    std::size_t m_baseOffset;
+};
+
+/*! Creates "count" FC objects from the same arguments in a single allocation
+ *  The layout is computed once, and the objects are constructed back-to-back,
+ *  each one aligned for its layout. If a construction throws, the objects
+ *  already created are destroyed and the allocation is released.
+ *  std::bad_array_new_length is thrown if the allocation size overflows.
+ */
+template <class FC, class Alloc, class AArgs, class... ClassArgs>
+batch<FC> makeNWithAllocator(Alloc& alloc, std::size_t count, AArgs& aArgs, ClassArgs&... cArgs)
+{
+    constexpr auto alignment = layoutAlignment<FC>::value;
+    const auto layout = computeLayout<FC>(aArgs);
+    const auto stride = findNextAlignedPosition(layout.bytes, alignment);
+    if (count > std::size_t(-1) / stride)
+        throw std::bad_array_new_length();
+
+    using Deleter = DeleteFn<FC, Alloc, alignment>;
+    auto memBuffer = unique_ptr_impl<void, Deleter>(
+        allocateWithAllocator<alignment>(alloc, count * stride), Deleter(alloc, count * stride));
+    auto slab = static_cast<std::byte*>(memBuffer.get());
+
+    std::size_t created = 0;
+    try
+    {
+        for (; created < count; ++created)
+        {
+            // Every object starts from the initial arguments
+            auto args = copy_tuple(aArgs);
+            BufferAllocator<alignment> buffer{slab + created * stride, stride};
+            makeWithAllocator<FC>(buffer, args, cArgs...);
+        }
+    }
+    catch (...)
+    {
+        while (created)
+            destroy_at(reinterpret_cast<FC*>(slab + --created * stride + layout.baseOffset));
+        throw;
+    }
+
+    memBuffer.release();
+    return batch<FC>(slab, count, stride, layout.baseOffset);
+}
+
+//! Destroys all objects of a batch and releases its allocation
+template <class FC, class Alloc>
+void destroyNWithAllocator(Alloc& alloc, const batch<FC>& b)
+{
+    if constexpr (!is_trivially_destructible_v<FC>)
+        for (auto i = b.size(); i > 0; --i)
+            destroy_at(&b[i - 1]);
+
+    deallocateWithAllocator<layoutAlignment<FC>::value>(alloc, b.data(), b.size() * b.stride());
+}
+
+template <class FC, class... AArgs>
+auto make_n(std::size_t count, AArgs&&... aArgs)
+{
+    return [a = fc::args(aArgs...), count](auto&&... cArgs) mutable {
+        NewDeleteAllocator alloc;
+        return fc::makeNWithAllocator<FC>(alloc, count, a, cArgs...);
+    };
+}
+
+template <class FC, class Alloc, class... AArgs>
+auto make_n(WithAllocator, Alloc& alloc, std::size_t count, AArgs&&... aArgs)
+{
+    return [a = fc::args(aArgs...), &alloc, count](auto&&... cArgs) mutable {
+        return fc::makeNWithAllocator<FC>(alloc, count, a, cArgs...);
+    };
+}
+
+template <class FC>
+void destroy_n(const batch<FC>& b)
+{
+    NewDeleteAllocator alloc;
+    destroyNWithAllocator(alloc, b);
+}
+
+template <class FC, class Alloc>
+void destroy_n(const batch<FC>& b, Alloc& alloc)
+{
+    destroyNWithAllocator(alloc, b);
+}
+
 template <class T>
 struct DestroyFn
 {
@@ -319,6 +1446,61 @@ auto make_unique(AArgs&&... aArgs)
     };
 }
 
+/*! Owns a FC stored in an internal buffer of "Bytes" bytes when it fits, or on
+ *  the heap otherwise. Meant for short-lived objects, to keep them off the heap.
+ *  The arrays may point into the internal buffer, so it can't be copied or moved.
+ *  Create it with fc::make_inline.
+ */
+template <class FC, std::size_t Bytes>
+class inline_storage
+{
+  public:
+    template <class... A, class... ClassArgs>
+    inline_storage(fc::tuple<A...>& aArgs, ClassArgs&&... cArgs)
+    {
+        if (computeLayout<FC>(aArgs).bytes <= Bytes)
+        {
+            BufferAllocator<alignment> alloc{m_buffer, Bytes};
+            m_ptr = makeWithAllocator<FC>(alloc, aArgs, std::forward<ClassArgs>(cArgs)...);
+        }
+        else
+            m_ptr = makeInternal<FC>(aArgs, std::forward<ClassArgs>(cArgs)...);
+    }
+
+    inline_storage(const inline_storage&) = delete;
+    inline_storage& operator=(const inline_storage&) = delete;
+
+    ~inline_storage()
+    {
+        if (isInline())
+            destroy_at(m_ptr);
+        else
+            destroy(m_ptr);
+    }
+
+    //! Whether the object lives in the internal buffer
+    bool isInline() const { return allocationBegin(m_ptr) == m_buffer; }
+
+    FC* get() const { return m_ptr; }
+    FC* operator->() const { return m_ptr; }
+    FC& operator*() const { return *m_ptr; }
+
+  private:
+    static constexpr std::size_t alignment = layoutAlignment<FC>::value;
+
+    FC* m_ptr;
+    alignas(alignment) std::byte m_buffer[Bytes];
+};
+
+//! Creates a FC in an fc::inline_storage<FC, Bytes>
+template <class FC, std::size_t Bytes, class... AArgs>
+auto make_inline(AArgs&&... aArgs)
+{
+    return [a = fc::args(aArgs...)](auto&&... cArgs) mutable {
+        return inline_storage<FC, Bytes>(a, std::forward<decltype(cArgs)>(cArgs)...);
+    };
+}
+
 } // namespace fc
 
 #endif // FC_FLEXCLASS_CORE_HPP
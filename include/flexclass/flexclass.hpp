@@ -3,8 +3,10 @@
 
 #include "algorithm.hpp"
 #include "arrays.hpp"
+#include "containers.hpp"
 #include "core.hpp"
 #include "memory.hpp"
+#include "resize.hpp"
 #include "tuple.hpp"
 #include "utility.hpp"
 
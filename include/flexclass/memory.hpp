@@ -1,8 +1,14 @@
 #ifndef FLEXCLASS_MEMORY_HPP
 #define FLEXCLASS_MEMORY_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <new>
 #include <utility>
+#include <vector>
+
+#include "utility.hpp"
 
 namespace fc
 {
@@ -12,9 +18,170 @@ namespace fc
 struct NewDeleteAllocator
 {
     void* allocate(std::size_t sz) { return ::operator new(sz); }
+    void* allocate(std::size_t sz, std::align_val_t al) { return ::operator new(sz, al); }
     void deallocate(void* ptr) { ::operator delete(ptr); }
+    void deallocate(void* ptr, std::size_t sz) { ::operator delete(ptr, sz); }
+    void deallocate(void* ptr, std::align_val_t al) { ::operator delete(ptr, al); }
+    void deallocate(void* ptr, std::size_t sz, std::align_val_t al)
+    {
+        ::operator delete(ptr, sz, al);
+    }
+};
+
+/*! Allocator interface
+ *
+ * The overloads mirror the ones of operator new/delete:
+ *
+ * // Required. Memory must be aligned as operator new(sz) would
+ * void* allocate(std::size_t sz);
+ * void deallocate(void* ptr);
+ *
+ * [optional]
+ * // Called instead of deallocate(void*) whenever the library knows
+ * // the size of the allocation (see fc::knowsAllocationSize)
+ * void deallocate(void* ptr, std::size_t sz);
+ *
+ * [optional]
+ * // Required to create types aligned beyond __STDCPP_DEFAULT_NEW_ALIGNMENT__
+ * void* allocate(std::size_t sz, std::align_val_t al);
+ * void deallocate(void* ptr, std::align_val_t al);
+ * void deallocate(void* ptr, std::size_t sz, std::align_val_t al); // [optional]
+ *
+ * [optional]
+ * // Returns memory filled with zeros (e.g. fresh pages or calloc). Used when
+ * // arrays are created with fc::zeroed, so that the library doesn't write the zeros
+ * void* allocate_zeroed(std::size_t sz);
+ * void* allocate_zeroed(std::size_t sz, std::align_val_t al); // for over-aligned types
+ *
+ * [optional]
+ * // Grows or shrinks the allocation "ptr" of "oldSize" bytes to "newSize" bytes
+ * // without moving it. Returns false, leaving the allocation untouched, if it
+ * // can't. Must succeed when shrinking back to a size it previously had.
+ * // Used by fc::resize to avoid relocating objects
+ * bool try_expand(void* ptr, std::size_t oldSize, std::size_t newSize);
+ */
+template <class Alloc, class Signature, class = void>
+struct canAllocate : std::false_type
+{
+};
+
+template <class Alloc, class... Args>
+struct canAllocate<Alloc, void(Args...),
+                   typename void_<decltype(std::declval<Alloc&>().allocate(
+                       std::declval<Args>()...))>::type> : std::true_type
+{
+};
+
+template <class Alloc, class Signature, class = void>
+struct canDeallocate : std::false_type
+{
+};
+
+template <class Alloc, class... Args>
+struct canDeallocate<Alloc, void(Args...),
+                     typename void_<decltype(std::declval<Alloc&>().deallocate(
+                         std::declval<void*>(), std::declval<Args>()...))>::type> : std::true_type
+{
+};
+
+template <class Alloc, class Signature, class = void>
+struct canAllocateZeroed : std::false_type
+{
+};
+
+template <class Alloc, class... Args>
+struct canAllocateZeroed<Alloc, void(Args...),
+                         typename void_<decltype(std::declval<Alloc&>().allocate_zeroed(
+                             std::declval<Args>()...))>::type> : std::true_type
+{
+};
+
+template <class Alloc>
+using hasSizedDeallocate = canDeallocate<Alloc, void(std::size_t)>;
+
+template <class Alloc, class = void>
+struct canTryExpand : std::false_type
+{
+};
+
+template <class Alloc>
+struct canTryExpand<Alloc, typename void_<decltype(std::declval<Alloc&>().try_expand(
+                               std::declval<void*>(), std::size_t(), std::size_t()))>::type>
+    : std::true_type
+{
 };
 
+//! Whether types aligned to "Align" need the aligned overloads of the allocator
+template <std::size_t Align>
+constexpr bool isOverAligned = Align > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+//! Allocates "sz" bytes aligned to "Align"
+template <std::size_t Align, class Alloc>
+void* allocateWithAllocator(Alloc& alloc, std::size_t sz)
+{
+    if constexpr (!isOverAligned<Align>)
+        return alloc.allocate(sz);
+    else
+    {
+        static_assert(canAllocate<Alloc, void(std::size_t, std::align_val_t)>::value,
+                      "This type is over-aligned: the allocator must provide "
+                      "allocate(std::size_t, std::align_val_t)");
+        return alloc.allocate(sz, std::align_val_t(Align));
+    }
+}
+
+//! Whether the allocator provides zero-filled memory aligned to "Align"
+template <std::size_t Align, class Alloc>
+constexpr bool hasZeroedAllocate =
+    isOverAligned<Align> ? canAllocateZeroed<Alloc, void(std::size_t, std::align_val_t)>::value
+                         : canAllocateZeroed<Alloc, void(std::size_t)>::value;
+
+//! Allocates "sz" zero-filled bytes aligned to "Align". Requires hasZeroedAllocate
+template <std::size_t Align, class Alloc>
+void* allocateZeroedWithAllocator(Alloc& alloc, std::size_t sz)
+{
+    if constexpr (!isOverAligned<Align>)
+        return alloc.allocate_zeroed(sz);
+    else
+        return alloc.allocate_zeroed(sz, std::align_val_t(Align));
+}
+
+//! Releases "ptr", using the sized overload when the allocator provides one
+template <std::size_t Align, class Alloc>
+void deallocateWithAllocator(Alloc& alloc, void* ptr, std::size_t sz)
+{
+    if constexpr (!isOverAligned<Align>)
+    {
+        if constexpr (hasSizedDeallocate<Alloc>::value)
+            alloc.deallocate(ptr, sz);
+        else
+            alloc.deallocate(ptr);
+    }
+    else
+    {
+        if constexpr (canDeallocate<Alloc, void(std::size_t, std::align_val_t)>::value)
+            alloc.deallocate(ptr, sz, std::align_val_t(Align));
+        else
+            alloc.deallocate(ptr, std::align_val_t(Align));
+    }
+}
+
+//! Releases "ptr" when its size is unknown
+template <std::size_t Align, class Alloc>
+void deallocateWithAllocator(Alloc& alloc, void* ptr)
+{
+    if constexpr (!isOverAligned<Align>)
+    {
+        static_assert(canDeallocate<Alloc, void()>::value,
+                      "This allocator requires the allocation size on deallocation, but it "
+                      "cannot be derived from the handles. Make the last handle a Range or "
+                      "an AdjacentRange.");
+        alloc.deallocate(ptr);
+    }
+    else
+        alloc.deallocate(ptr, std::align_val_t(Align));
+}
+
 template <class T>
 struct ArrayDeleter
 {
@@ -42,6 +209,421 @@ constexpr std::uintptr_t findNextAlignedPosition(T* ptr, std::size_t desiredAlig
                                    currentAlignment);
 }
 
+/*! Bump-pointer allocator
+ *  Objects are carved sequentially from large chunks obtained from operator new.
+ *  Each new chunk is twice as large as the previous one, so a large build only
+ *  touches the system allocator a logarithmic number of times.
+ *
+ *  "deallocate" is a no-op: memory is only reclaimed by "reset" or when the
+ *  arena is destroyed. If fc::is_trivially_destructible_v<FC> holds, the
+ *  objects don't even need to go through fc::destroy before that.
+ */
+class Arena
+{
+  public:
+    static constexpr std::size_t defaultChunkSize = std::size_t(64) << 10;
+
+    explicit Arena(std::size_t firstChunkSize = defaultChunkSize) : m_nextChunkSize(firstChunkSize)
+    {
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept
+        : m_chunk(std::exchange(other.m_chunk, nullptr)), m_cur(std::exchange(other.m_cur, 0)),
+          m_end(std::exchange(other.m_end, 0)), m_nextChunkSize(other.m_nextChunkSize)
+    {
+    }
+
+    ~Arena() { releaseChunks(nullptr); }
+
+    void* allocate(std::size_t sz) { return allocate(sz, std::align_val_t(alignment)); }
+
+    void* allocate(std::size_t sz, std::align_val_t al)
+    {
+        auto a = static_cast<std::size_t>(al);
+        auto pos = findNextAlignedPosition(m_cur, a);
+        if (!m_chunk || pos + sz > m_end)
+        {
+            addChunk(sz + a);
+            pos = findNextAlignedPosition(m_cur, a);
+        }
+        m_cur = pos + sz;
+        return reinterpret_cast<void*>(pos);
+    }
+
+    void deallocate(void*) {}
+    void deallocate(void*, std::align_val_t) {}
+
+    //! Resizes "ptr" in place if it is the most recent allocation and fits in its chunk
+    bool try_expand(void* ptr, std::size_t oldSize, std::size_t newSize)
+    {
+        auto pos = reinterpret_cast<std::uintptr_t>(ptr);
+        if (pos + oldSize != m_cur || pos + newSize > m_end)
+            return false;
+        m_cur = pos + newSize;
+        return true;
+    }
+
+    /*! Releases all objects at once
+     *  The most recent (and largest) chunk is kept to serve the next allocations,
+     *  all others are returned to the system. No destructor is called.
+     */
+    void reset()
+    {
+        if (!m_chunk)
+            return;
+        releaseChunks(m_chunk);
+        m_chunk->m_prev = nullptr;
+        m_cur = chunkBegin(m_chunk);
+    }
+
+    /*! Makes sure the next "sz" bytes can be allocated without adding a chunk
+     *  Pair it with fc::layout_of to reserve the memory of a whole build at once.
+     */
+    void reserve(std::size_t sz)
+    {
+        // The next allocation starts at the next aligned position
+        if (!m_chunk || findNextAlignedPosition(m_cur, alignment) + sz > m_end)
+            addChunk(sz);
+    }
+
+    //! Number of bytes obtained from the system, including chunk headers
+    std::size_t capacity() const
+    {
+        std::size_t total = 0;
+        for (auto c = m_chunk; c; c = c->m_prev)
+            total += c->m_size;
+        return total;
+    }
+
+  private:
+    static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    struct Chunk
+    {
+        Chunk* m_prev;
+        std::size_t m_size;
+    };
+
+    static std::uintptr_t chunkBegin(Chunk* c)
+    {
+        return findNextAlignedPosition(reinterpret_cast<std::uintptr_t>(c + 1), alignment);
+    }
+
+    void addChunk(std::size_t minSize)
+    {
+        auto size = m_nextChunkSize;
+        while (size < minSize + sizeof(Chunk) + alignment)
+            size *= 2;
+
+        auto c = static_cast<Chunk*>(::operator new(size));
+        c->m_prev = m_chunk;
+        c->m_size = size;
+
+        m_chunk = c;
+        m_cur = chunkBegin(c);
+        m_end = reinterpret_cast<std::uintptr_t>(c) + size;
+        m_nextChunkSize = size * 2;
+    }
+
+    //! Releases all chunks allocated before "keep"
+    void releaseChunks(Chunk* keep)
+    {
+        auto c = keep ? keep->m_prev : m_chunk;
+        while (c)
+            ::operator delete(std::exchange(c, c->m_prev));
+    }
+
+    Chunk* m_chunk{nullptr};
+    std::uintptr_t m_cur{0};
+    std::uintptr_t m_end{0};
+    std::size_t m_nextChunkSize;
+};
+
+namespace detail
+{
+
+constexpr std::size_t floorLog2(std::size_t v)
+{
+    std::size_t r = 0;
+    while (v >>= 1)
+        r++;
+    return r;
+}
+
+/*! Size classes used by fc::PoolAllocator
+ *  Sizes up to "maxSmallSize" are rounded up to multiples of "granularity".
+ *  Above that, every power of two is split into 4 classes, up to "maxSize".
+ */
+struct SizeClasses
+{
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t maxSmallSize = 256;
+    static constexpr std::size_t maxSize = std::size_t(64) << 10;
+    static constexpr std::size_t numSmall = maxSmallSize / granularity;
+    static constexpr std::size_t count =
+        numSmall + 4 * (floorLog2(maxSize) - floorLog2(maxSmallSize));
+
+    //! Index of the smallest class that fits "sz" bytes. Requires sz <= maxSize
+    static constexpr std::size_t index(std::size_t sz)
+    {
+        if (sz <= maxSmallSize)
+            return sz ? (sz - 1) / granularity : 0;
+        auto p = floorLog2(sz - 1);
+        return numSmall + (p - floorLog2(maxSmallSize)) * 4 + ((sz - 1) >> (p - 2)) - 4;
+    }
+
+    //! Number of bytes in each block of class "idx"
+    static constexpr std::size_t size(std::size_t idx)
+    {
+        if (idx < numSmall)
+            return (idx + 1) * granularity;
+        auto k = idx - numSmall;
+        auto p = floorLog2(maxSmallSize) + k / 4;
+        return (std::size_t(1) << p) + (k % 4 + 1) * (std::size_t(1) << (p - 2));
+    }
+
+    //! Number of blocks moved at once between a magazine and the depot
+    static constexpr std::size_t batchSize(std::size_t idx)
+    {
+        auto n = (std::size_t(64) << 10) / size(idx);
+        return n < 2 ? 2 : n > 32 ? 32 : n;
+    }
+};
+
+//! A free block. Blocks are chained into batches, and batches into the depot
+struct PoolBlock
+{
+    PoolBlock* m_next;
+    PoolBlock* m_nextBatch;
+};
+
+/*! Process-wide storage of free blocks, shared by all threads
+ *  Blocks are exchanged with the thread-local magazines in whole batches,
+ *  so the lock is taken once every "batchSize" allocations at most.
+ */
+class PoolDepot
+{
+  public:
+    static PoolDepot& instance()
+    {
+        static PoolDepot depot;
+        return depot;
+    }
+
+    ~PoolDepot()
+    {
+        for (auto slab : m_slabs)
+            ::operator delete(slab);
+    }
+
+    //! Returns a null-terminated chain of free blocks of class "cls"
+    PoolBlock* popBatch(std::size_t cls)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto batch = m_batches[cls])
+            {
+                m_batches[cls] = batch->m_nextBatch;
+                return batch;
+            }
+        }
+        return carveBatch(cls);
+    }
+
+    //! Takes ownership of a null-terminated chain of free blocks of class "cls"
+    void pushBatch(std::size_t cls, PoolBlock* batch)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        batch->m_nextBatch = m_batches[cls];
+        m_batches[cls] = batch;
+    }
+
+  private:
+    PoolDepot() = default;
+
+    PoolBlock* carveBatch(std::size_t cls)
+    {
+        auto sz = SizeClasses::size(cls);
+        auto n = SizeClasses::batchSize(cls);
+        auto slab = static_cast<std::byte*>(::operator new(sz * n));
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slabs.push_back(slab);
+        }
+        catch (...)
+        {
+            ::operator delete(slab);
+            throw;
+        }
+
+        PoolBlock* head = nullptr;
+        while (n--)
+        {
+            auto block = reinterpret_cast<PoolBlock*>(slab + n * sz);
+            block->m_next = head;
+            head = block;
+        }
+        return head;
+    }
+
+    std::mutex m_mutex;
+    PoolBlock* m_batches[SizeClasses::count]{};
+    std::vector<void*> m_slabs;
+};
+
+/*! Per-thread cache of free blocks, one free-list per size class
+ *  Allocation and deallocation only touch the depot when a list runs empty
+ *  or grows beyond two batches.
+ */
+class PoolMagazines
+{
+  public:
+    static PoolMagazines& local()
+    {
+        static thread_local PoolMagazines magazines;
+        return magazines;
+    }
+
+    PoolMagazines(const PoolMagazines&) = delete;
+    PoolMagazines& operator=(const PoolMagazines&) = delete;
+
+    ~PoolMagazines()
+    {
+        for (std::size_t cls = 0; cls < SizeClasses::count; ++cls)
+            if (m_lists[cls].m_head)
+                m_depot.pushBatch(cls, m_lists[cls].m_head);
+    }
+
+    void* pop(std::size_t cls)
+    {
+        auto& list = m_lists[cls];
+        if (!list.m_head)
+        {
+            list.m_head = m_depot.popBatch(cls);
+            for (auto b = list.m_head; b; b = b->m_next)
+                list.m_count++;
+        }
+        list.m_count--;
+        return std::exchange(list.m_head, list.m_head->m_next);
+    }
+
+    void push(std::size_t cls, void* ptr)
+    {
+        auto& list = m_lists[cls];
+        auto block = static_cast<PoolBlock*>(ptr);
+        block->m_next = list.m_head;
+        list.m_head = block;
+
+        auto batch = SizeClasses::batchSize(cls);
+        if (++list.m_count < 2 * batch)
+            return;
+
+        // Give the first batch back to the depot
+        auto last = list.m_head;
+        for (std::size_t i = 1; i < batch; ++i)
+            last = last->m_next;
+        auto batchHead = std::exchange(list.m_head, last->m_next);
+        last->m_next = nullptr;
+        list.m_count -= batch;
+        m_depot.pushBatch(cls, batchHead);
+    }
+
+  private:
+    PoolMagazines() : m_depot(PoolDepot::instance()) {}
+
+    struct FreeList
+    {
+        PoolBlock* m_head{nullptr};
+        std::size_t m_count{0};
+    };
+
+    PoolDepot& m_depot;
+    FreeList m_lists[SizeClasses::count];
+};
+
+} // namespace detail
+
+/*! Size-class pool allocator
+ *  Requests are rounded up to a size class, so objects whose arrays have slightly
+ *  different lengths share the same free-lists. Each thread caches free blocks
+ *  in its own magazines and only synchronizes with the shared depot to exchange
+ *  whole batches.
+ *
+ *  Blocks carry no header: the size class is recomputed from the size passed
+ *  to "deallocate", so the types allocated from the pool must be able to
+ *  derive their allocation size from their handles (see fc::knowsAllocationSize).
+ *
+ *  Blocks are never returned to the system before the program exits.
+ *  Requests larger than detail::SizeClasses::maxSize go straight to operator new.
+ */
+struct PoolAllocator
+{
+    void* allocate(std::size_t sz)
+    {
+        if (sz > detail::SizeClasses::maxSize)
+            return ::operator new(sz);
+        return detail::PoolMagazines::local().pop(detail::SizeClasses::index(sz));
+    }
+
+    void deallocate(void* ptr, std::size_t sz)
+    {
+        if (sz > detail::SizeClasses::maxSize)
+            ::operator delete(ptr, sz);
+        else
+            detail::PoolMagazines::local().push(detail::SizeClasses::index(sz), ptr);
+    }
+
+    //! Blocks are as large as their size class, so any size of the same class fits in place
+    bool try_expand(void* ptr, std::size_t oldSize, std::size_t newSize)
+    {
+        using detail::SizeClasses;
+        if (oldSize > SizeClasses::maxSize || newSize > SizeClasses::maxSize)
+            return oldSize == newSize;
+        return SizeClasses::index(oldSize) == SizeClasses::index(newSize);
+    }
+};
+
+/*! Serves one allocation from a caller-provided buffer of "m_capacity" bytes
+ *  The allocation starts at the first position of the buffer aligned to "Align".
+ *  Throws std::bad_alloc if it doesn't fit. "deallocate" is a no-op: the buffer
+ *  belongs to the caller. Used by fc::make_at and fc::destroy_at.
+ */
+template <std::size_t Align>
+struct BufferAllocator
+{
+    void* allocate(std::size_t sz)
+    {
+        auto begin = reinterpret_cast<std::uintptr_t>(m_buffer);
+        auto pos = findNextAlignedPosition(begin, Align);
+        if (!m_buffer || pos - begin + sz > m_capacity)
+            throw std::bad_alloc();
+        return reinterpret_cast<void*>(pos);
+    }
+
+    void* allocate(std::size_t sz, std::align_val_t) { return allocate(sz); }
+
+    void deallocate(void*) {}
+    void deallocate(void*, std::align_val_t) {}
+
+    void* m_buffer;
+    std::size_t m_capacity;
+};
+
+//! Lets the compiler assume "ptr" is aligned to "Align" (e.g. to emit aligned vector loads)
+template <std::size_t Align, class T>
+T* assumeAligned(T* ptr)
+{
+#if defined(__GNUC__)
+    return static_cast<T*>(__builtin_assume_aligned(ptr, Align));
+#else
+    return ptr;
+#endif
+}
+
 template <class T, class U>
 constexpr auto align(U* u)
 {
@@ -129,22 +711,25 @@ struct unique_ptr_impl : private Deleter
 };
 
 /*! Two step deleter
- *  It manages a void* that is deallocated with the allocator.
+ *  It manages a void* of "size" bytes that is deallocated with the allocator.
  *  The user can then set "m_objectCreated" to true, and it will
  *  also call the destructor of such type.
  */
-template <class T, class Alloc>
+template <class T, class Alloc, std::size_t Align = alignof(T)>
 struct DeleteFn
 {
-    DeleteFn(Alloc& alloc) : m_alloc(&alloc) {}
+    DeleteFn(Alloc& alloc, std::size_t size) : m_alloc(&alloc), m_size(size) {}
     void operator()(void* ptr) const
     {
         if (m_objectCreated)
-            static_cast<T*>(ptr)->~T();
-        m_alloc->deallocate(ptr);
+            reinterpret_cast<T*>(static_cast<std::byte*>(ptr) + m_baseOffset)->~T();
+        deallocateWithAllocator<Align>(*m_alloc, ptr, m_size);
     }
     Alloc* m_alloc;
+    std::size_t m_size;
     bool m_objectCreated{false};
+    //! Offset of the object in the allocation (see Layout::baseOffset)
+    std::size_t m_baseOffset{0};
 };
 
 } // namespace fc
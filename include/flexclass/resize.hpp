@@ -0,0 +1,374 @@
+#ifndef FC_FLEXCLASS_RESIZE_HPP
+#define FC_FLEXCLASS_RESIZE_HPP
+
+#include "core.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace fc
+{
+
+//! Growth policy that reserves room for exactly the requested elements
+struct ExactGrowth
+{
+    std::size_t operator()(std::size_t capacity, std::size_t size) const { return size; }
+};
+
+/*! Growth policy that at least doubles the capacity
+ *  Appending elements one by one then copies each element O(1) times on average
+ */
+struct GeometricGrowth
+{
+    std::size_t operator()(std::size_t capacity, std::size_t size) const
+    {
+        return std::max(size, 2 * capacity);
+    }
+};
+
+static constexpr ExactGrowth exact_growth;
+static constexpr GeometricGrowth geometric_growth;
+
+//! Whether all handles of FC provide "end", so that the size of every array is known
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct allHandlesHaveEnd;
+
+template <class FC, class... H>
+struct allHandlesHaveEnd<FC, fc::tuple<H*...>>
+    : std::bool_constant<(hasEnd<H, FC>::value && ...)>
+{
+};
+
+//! Whether all arrays of FC are plain arrays of their fc_handle_type (see hasPlainArray)
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct allArraysArePlain;
+
+template <class FC, class... H>
+struct allArraysArePlain<FC, fc::tuple<H*...>>
+    : std::bool_constant<(hasPlainArray<H>::value && ...)>
+{
+};
+
+//! Whether FC and the elements of its arrays can be moved without throwing
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct isNothrowRelocatable;
+
+template <class FC, class... H>
+struct isNothrowRelocatable<FC, fc::tuple<H*...>>
+    : std::bool_constant<std::is_nothrow_move_constructible_v<FC> &&
+                         (std::is_nothrow_move_constructible_v<typename H::fc_handle_type> &&
+                          ...)>
+{
+};
+
+/*! Whether T can be relocated by copying its bytes, without calling its move
+ *  constructor and destructor. By default that is the case of trivially
+ *  copyable types. Specialize it for other types known to be, e.g.:
+ *
+ *    template <>
+ *    struct fc::is_trivially_relocatable<Buffer> : std::true_type {};
+ *
+ *  A flexclass is trivially relocatable if its base is trivially copyable and
+ *  the elements of all its arrays are trivially relocatable. Such an object is
+ *  relocated with a single memcpy, and only its handles need to be updated.
+ */
+template <class T, class = void>
+struct is_trivially_relocatable : std::is_trivially_copyable<T>
+{
+};
+
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct arraysAreTriviallyRelocatable;
+
+template <class FC, class... H>
+struct arraysAreTriviallyRelocatable<FC, fc::tuple<H*...>>
+    : std::bool_constant<((is_trivially_relocatable<typename H::fc_handle_type>::value &&
+                           !hasDestroyElements<H, FC>::value) &&
+                          ...)>
+{
+};
+
+//! Whether the library destroys the elements of all arrays of FC (see hasDestroyElements)
+template <class FC, class Handles = decltype(std::declval<FC&>().fc_handles())>
+struct noHandleDestroysElements;
+
+template <class FC, class... H>
+struct noHandleDestroysElements<FC, fc::tuple<H*...>>
+    : std::bool_constant<(!hasDestroyElements<H, FC>::value && ...)>
+{
+};
+
+template <class FC>
+struct is_trivially_relocatable<
+    FC, typename void_<decltype(std::declval<FC&>().fc_handles())>::type>
+    : std::bool_constant<std::is_trivially_copyable_v<FC> &&
+                         arraysAreTriviallyRelocatable<FC>::value>
+{
+};
+
+template <class T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/*! Default-initializes the elements from begin + oldSize up to begin + newSize,
+ *  or destroys the elements from begin + newSize up to begin + oldSize
+ */
+template <class T>
+void resizeElements(T* begin, std::size_t oldSize, std::size_t newSize)
+{
+    if (newSize < oldSize)
+        reverseDestroy(begin + newSize, begin + oldSize);
+    else if (newSize > oldSize)
+    {
+        ArrayBuilder<T> builder;
+        Arg<detail::NoIterator> arg(newSize - oldSize);
+        builder.buildArray(reinterpret_cast<std::byte*>(begin + oldSize), arg);
+        builder.release();
+    }
+}
+
+//! Lets "handle" know its array has "size" elements from begin, with room up to begin + capacity
+template <class FC, class Handle, class T>
+void setLocation(Handle* handle, T* begin, std::size_t size, std::size_t capacity)
+{
+    handle->setLocation(begin, begin + size);
+    if constexpr (hasCapacityEnd<Handle, FC>::value)
+        handle->setCapacityEnd(begin + capacity);
+}
+
+/*! Changes the number of elements of the Idx-th array of "ptr" to "newSize"
+ *  New elements are default-initialized, as with fc::make. Returns the object,
+ *  which moves to a new allocation unless the array can be resized in place:
+ *
+ *  - the handle keeps room for "newSize" elements (see GrowableRange), or
+ *  - the array is the last one after the base and the allocator can resize
+ *    the allocation in place (see "try_expand" in the allocator interface).
+ *
+ *  Otherwise all arrays are moved to a new allocation from "alloc" and the
+ *  handles are updated with setLocation. The "growth" policy decides how much
+ *  room a GrowableRange keeps past the new size.
+ *
+ *  If an exception is thrown, "ptr" is left untouched.
+ */
+template <int Idx, class FC, class Alloc, class Growth = ExactGrowth>
+FC* resize(FC* ptr, Alloc& alloc, std::size_t newSize, Growth growth = {})
+{
+    using Handles = decltype(ptr->fc_handles());
+    constexpr auto numHandles = Handles::Size;
+    static_assert(Idx >= 0 && Idx < int(numHandles), "Invalid handle index");
+    static_assert(allHandlesHaveEnd<FC>::value,
+                  "fc::resize needs the size of every array: all handles must provide end()");
+    static_assert(allArraysArePlain<FC>::value,
+                  "fc::resize only supports handles without a custom fc_array_builder");
+    static_assert(isNothrowRelocatable<FC>::value,
+                  "fc::resize moves objects around: FC and the elements of its arrays must "
+                  "have noexcept move constructors");
+
+    auto&& handles = ptr->fc_handles();
+    auto handle = handles.template get<Idx>();
+    using Handle = remove_cvref_t<decltype(*handle)>;
+
+    auto begin = handle->begin(ptr);
+    std::size_t oldSize = handle->end(ptr) - begin;
+
+    // There is room left in the array
+    if constexpr (hasCapacityEnd<Handle, FC>::value)
+    {
+        std::size_t capacity = handle->capacity_end(ptr) - begin;
+        if (newSize <= capacity)
+        {
+            resizeElements(begin, oldSize, newSize);
+            setLocation<FC>(handle, begin, newSize, capacity);
+            return ptr;
+        }
+    }
+
+    // Number of elements and of reserved elements of each array
+    std::array<std::size_t, numHandles> sizes{}, capacities{};
+    for_each_in_tuple(handles, [&](auto* h, auto idx) {
+        auto b = h->begin(ptr);
+        sizes[idx] = h->end(ptr) - b;
+        capacities[idx] = storageEnd(*h, ptr) - b;
+    });
+
+    auto newCapacity = newSize;
+    if constexpr (hasCapacityEnd<Handle, FC>::value)
+        newCapacity = growth(capacities[Idx], newSize);
+    capacities[Idx] = newCapacity;
+
+    auto oldMem = allocationBegin(ptr);
+    auto oldBytes = allocationSize(ptr);
+    auto layout = layoutFromSizes<FC>(capacities);
+
+    // The last array can grow or shrink with the allocation itself
+    if constexpr (Idx == layoutOrder<FC>::value[numHandles - 1] && !isPreceding<Handle>::value &&
+                  canTryExpand<Alloc>::value)
+    {
+        if (alloc.try_expand(oldMem, oldBytes, layout.bytes))
+        {
+            try
+            {
+                resizeElements(begin, oldSize, newSize);
+            }
+            catch (...)
+            {
+                alloc.try_expand(oldMem, layout.bytes, oldBytes);
+                throw;
+            }
+            setLocation<FC>(handle, begin, newSize, newCapacity);
+            return ptr;
+        }
+    }
+
+    // Relocate the whole object. The new elements are created first: that is
+    // the only step that may throw
+    constexpr auto alignment = layoutAlignment<FC>::value;
+    using Deleter = DeleteFn<FC, Alloc, alignment>;
+    auto memBuffer = unique_ptr_impl<void, Deleter>(
+        allocateWithAllocator<alignment>(alloc, layout.bytes), Deleter(alloc, layout.bytes));
+    auto mem = static_cast<std::byte*>(memBuffer.get());
+
+    using T = typename Handle::fc_handle_type;
+    auto newBegin = reinterpret_cast<T*>(mem + layout.offsets[Idx]);
+    if (newSize > oldSize)
+        resizeElements(newBegin, oldSize, newSize);
+    sizes[Idx] = std::min(oldSize, newSize);
+
+    // Move the elements and destroy the old ones, in reverse order of creation
+    for_each_in_tuple(handles, [&](auto* h, auto idx) {
+        using U = typename remove_cvref_t<decltype(*h)>::fc_handle_type;
+        std::uninitialized_move_n(h->begin(ptr), sizes[idx],
+                                  reinterpret_cast<U*>(mem + layout.offsets[idx]));
+    });
+    reverse_for_each_in_tuple(handles, [&](auto* h, auto idx) {
+        using U = typename remove_cvref_t<decltype(*h)>::fc_handle_type;
+        if constexpr (!std::is_trivially_destructible_v<U>)
+            reverseDestroy(h->begin(ptr), h->end(ptr));
+    });
+
+    auto ret = ::new (mem + layout.baseOffset) FC(std::move(*ptr));
+    ptr->~FC();
+    deallocateWithAllocator<alignment>(alloc, oldMem, oldBytes);
+    memBuffer.release();
+
+    sizes[Idx] = newSize;
+    for_each_in_tuple(ret->fc_handles(), [&](auto* h, auto idx) {
+        using U = typename remove_cvref_t<decltype(*h)>::fc_handle_type;
+        auto b = reinterpret_cast<U*>(mem + layout.offsets[idx]);
+        setLocation<FC>(h, b, sizes[idx], capacities[idx]);
+    });
+    return ret;
+}
+
+/*! Moves the object "src" to the allocation "dst" and returns the new object
+ *  "dst" must be aligned for the object (see fc::layout_of) and have room
+ *  for fc::allocated_size(src) bytes, without overlapping "src". The object
+ *  is at "dst" itself, unless arrays precede it (see PrecedingArray). The base and
+ *  the elements of all arrays are moved, keeping the same layout, and then
+ *  setLocation is called on every handle of the new object, which keeps the
+ *  room reserved past the end of its array (see GrowableRange).
+ *  Afterwards, "src" holds no object: its memory can be released by the
+ *  caller (e.g. with Arena::reset when compacting an arena).
+ *
+ *  Trivially relocatable objects (see fc::is_trivially_relocatable) are
+ *  copied with a single memcpy. Handles that don't provide "end" are only
+ *  supported in that case, and receive their new begin as both begin and end.
+ *  Other objects are moved array by array, which requires all handles to
+ *  provide "end" and noexcept move constructors.
+ */
+template <class FC>
+FC* relocate(FC* src, void* dst)
+{
+    static_assert(knowsAllocationSize<FC>::value,
+                  "fc::relocate needs the allocation size: the last handle must provide end()");
+
+    constexpr auto alignment = layoutAlignment<FC>::value;
+    assert(reinterpret_cast<std::uintptr_t>(dst) % alignment == 0);
+
+    auto srcBytes = allocationBegin(src);
+    auto dstBytes = static_cast<std::byte*>(dst);
+    std::size_t baseOffset = reinterpret_cast<std::byte*>(src) - srcBytes;
+
+    // Byte offsets of the begin, end and storage end of each array, the same in both places
+    using Handles = decltype(src->fc_handles());
+    std::array<std::size_t, Handles::Size> begins{}, ends{}, storageEnds{};
+    for_each_in_tuple(src->fc_handles(), [&](auto* h, auto idx) {
+        using Handle = remove_cvref_t<decltype(*h)>;
+        begins[idx] = reinterpret_cast<std::byte*>(h->begin(src)) - srcBytes;
+        if constexpr (hasEnd<Handle, FC>::value)
+        {
+            ends[idx] = reinterpret_cast<std::byte*>(h->end(src)) - srcBytes;
+            storageEnds[idx] =
+                reinterpret_cast<const std::byte*>(storageEnd(*h, src)) - srcBytes;
+        }
+        else
+            ends[idx] = storageEnds[idx] = begins[idx];
+    });
+
+    FC* ret;
+    if constexpr (is_trivially_relocatable_v<FC>)
+    {
+        std::memcpy(dst, srcBytes, allocationSize(src));
+        ret = reinterpret_cast<FC*>(dstBytes + baseOffset);
+    }
+    else
+    {
+        static_assert(allHandlesHaveEnd<FC>::value,
+                      "fc::relocate moves each array: all handles must provide end()");
+        static_assert(noHandleDestroysElements<FC>::value,
+                      "fc::relocate can't move objects that handles destroy themselves "
+                      "(e.g. the flexclasses of a NestedArray)");
+        static_assert(isNothrowRelocatable<FC>::value,
+                      "fc::relocate moves objects around: FC and the elements of its arrays "
+                      "must have noexcept move constructors");
+
+        for_each_in_tuple(src->fc_handles(), [&](auto* h, auto idx) {
+            using U = typename remove_cvref_t<decltype(*h)>::fc_handle_type;
+            auto b = h->begin(src);
+            auto n = h->end(src) - b;
+            auto newBegin = reinterpret_cast<U*>(dstBytes + begins[idx]);
+            if constexpr (is_trivially_relocatable_v<U>)
+                std::memcpy(static_cast<void*>(newBegin), b, n * sizeof(U));
+            else
+                std::uninitialized_move_n(b, n, newBegin);
+
+            // Data kept past the elements is trivially copyable
+            using Handle = remove_cvref_t<decltype(*h)>;
+            if constexpr (hasStorageEnd<Handle, FC>::value)
+                std::memcpy(dstBytes + ends[idx], srcBytes + ends[idx],
+                            storageEnds[idx] - ends[idx]);
+        });
+        reverse_for_each_in_tuple(src->fc_handles(), [&](auto* h, auto idx) {
+            using U = typename remove_cvref_t<decltype(*h)>::fc_handle_type;
+            if constexpr (!is_trivially_relocatable_v<U>)
+                reverseDestroy(h->begin(src), h->end(src));
+        });
+
+        ret = ::new (dstBytes + baseOffset) FC(std::move(*src));
+        src->~FC();
+    }
+
+    for_each_in_tuple(ret->fc_handles(), [&](auto* h, auto idx) {
+        using U = typename remove_cvref_t<decltype(*h)>::fc_handle_type;
+        setLocation<FC>(h, reinterpret_cast<U*>(dstBytes + begins[idx]),
+                        (ends[idx] - begins[idx]) / sizeof(U),
+                        (storageEnds[idx] - begins[idx]) / sizeof(U));
+    });
+    return ret;
+}
+
+//! Resizes the Idx-th array of an object created with fc::make
+template <int Idx, class FC, class Growth = ExactGrowth>
+FC* resize(FC* ptr, std::size_t newSize, Growth growth = {})
+{
+    NewDeleteAllocator alloc;
+    return resize<Idx>(ptr, alloc, newSize, growth);
+}
+
+} // namespace fc
+
+#endif // FC_FLEXCLASS_RESIZE_HPP
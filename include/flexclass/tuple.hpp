@@ -205,7 +205,7 @@ void for_each_zipped(T1& t1, T2& t2, F f)
 }
 
 template <int I, class Fn, class First, class... T>
-void for_each_constexpr_impl2(Fn&& fn)
+constexpr void for_each_constexpr_impl2(Fn&& fn)
 {
     fn(static_cast<First*>(nullptr), std::integral_constant<int, I>());
     if constexpr (sizeof...(T) > 0)
@@ -213,18 +213,31 @@ void for_each_constexpr_impl2(Fn&& fn)
 }
 
 template <class Fn, class... T>
-void for_each_constexpr_impl(Fn&& fn, fc::tuple<T...>*)
+constexpr void for_each_constexpr_impl(Fn&& fn, fc::tuple<T...>*)
 {
     if constexpr (sizeof...(T) > 0)
         for_each_constexpr_impl2<0, Fn, T...>(fn);
 }
 
 template <class Tuple, class Fn>
-void for_each_constexpr(Fn&& fn)
+constexpr void for_each_constexpr(Fn&& fn)
 {
     for_each_constexpr_impl(fn, static_cast<Tuple*>(nullptr));
 }
 
+template <class... T, int... Is>
+tuple<T...> copy_tuple(const tuple<T...>& t, std::integer_sequence<int, Is...>)
+{
+    return tuple<T...>(t.template get<Is>()...);
+}
+
+//! Copies each element of "t" into a new tuple, as tuples themselves are not copyable
+template <class... T>
+tuple<T...> copy_tuple(const tuple<T...>& t)
+{
+    return copy_tuple(t, std::make_integer_sequence<int, sizeof...(T)>());
+}
+
 template <class... Args>
 auto make_tuple(Args&&... args)
 {
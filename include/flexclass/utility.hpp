@@ -1,6 +1,15 @@
 #ifndef FLEXCLASS_UTILITY_HPP
 #define FLEXCLASS_UTILITY_HPP
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace fc
 {
 
@@ -15,6 +24,56 @@ struct void_
 template <class T>
 using remove_cvref_t = std::remove_cv_t<std::remove_reference_t<T>>;
 
+//! Non-owning view over the contiguous elements from m_begin up to m_end
+template <class T>
+struct span
+{
+    T* begin() const { return m_begin; }
+    T* end() const { return m_end; }
+    T* data() const { return m_begin; }
+
+    std::size_t size() const { return m_end - m_begin; }
+    bool empty() const { return m_begin == m_end; }
+
+    T& operator[](std::size_t i) const { return m_begin[i]; }
+
+    T* m_begin;
+    T* m_end;
+};
+
+//! Number of bits set in "word" (a single popcnt instruction where available)
+inline int popcount(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(word));
+#else
+    int n = 0;
+    for (; word; word &= word - 1)
+        ++n;
+    return n;
+#endif
+}
+
+//! Index of the lowest bit set in "word", which must not be 0 (tzcnt where available)
+inline int countTrailingZeros(std::uint64_t word)
+{
+    assert(word != 0);
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    int n = 0;
+    for (; !(word & 1); word >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
 } // namespace fc
 
 #endif
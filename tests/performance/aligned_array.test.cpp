@@ -0,0 +1,79 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch.hpp>
+#include <flexclass.hpp>
+
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    // A header whose size is not a multiple of the cache line,
+    //   so the default layout doesn't start the floats on a boundary
+    struct Samples
+    {
+        auto fc_handles() { return fc::make_tuple(&values); }
+
+        std::uint32_t id;
+        std::uint16_t channel;
+        fc::Array<float> values;
+    };
+
+    struct AlignedSamples
+    {
+        auto fc_handles() { return fc::make_tuple(&values); }
+
+        std::uint32_t id;
+        std::uint16_t channel;
+        fc::AlignedArray<float, 64> values;
+    };
+
+    // Sum with independent lanes so the compiler can vectorize without reassociating
+    template<class Ptr>
+    float laneSum(Ptr b, std::size_t n)
+    {
+        constexpr std::size_t lanes = 16;
+        float acc[lanes] = {};
+        std::size_t i = 0;
+        for (; i + lanes <= n; i += lanes)
+            for (std::size_t l = 0; l < lanes; ++l)
+                acc[l] += b[i + l];
+        for (; i < n; ++i)
+            acc[0] += b[i];
+        return std::accumulate(acc, acc + lanes, 0.f);
+    }
+
+    template<class FC>
+    auto makeAll(std::size_t numObjects, std::size_t numValues)
+    {
+        std::vector<fc::unique_ptr<FC>> objs;
+        for (std::size_t i = 0; i < numObjects; ++i)
+        {
+            objs.push_back(fc::make_unique<FC>(numValues)());
+            auto b = objs.back()->values.begin();
+            std::iota(b, b + numValues, float(i));
+        }
+        return objs;
+    }
+}
+
+TEST_CASE( "Vectorized sum over Array<float> vs AlignedArray<float, 64>", "[alignment]")
+{
+    static constexpr std::size_t numObjects = 1000;
+    static constexpr std::size_t numValues = 1021;
+
+    auto unaligned = makeAll<Samples>(numObjects, numValues);
+    auto aligned = makeAll<AlignedSamples>(numObjects, numValues);
+
+    BENCHMARK("Sum Array<float>") {
+        float sum = 0;
+        for (auto& o : unaligned) sum += laneSum(o->values.begin(), numValues);
+        return sum;
+    };
+
+    BENCHMARK("Sum AlignedArray<float, 64>") {
+        float sum = 0;
+        for (auto& o : aligned) sum += laneSum(o->values.begin(), numValues);
+        return sum;
+    };
+}
@@ -31,6 +31,14 @@ namespace nofc
         std::vector<std::unique_ptr<Node>> nodes;
     };
 
+    auto addNode(Dag& g, std::size_t id, std::size_t numLinks)
+    {
+        g.nodes.push_back(Node::make_unique(id, numLinks, false, numLinks));
+        return g.nodes.back().get();
+    }
+
+    auto getNode(Dag& g, std::size_t i) { return g.nodes[i].get(); }
+
 }
 
 namespace withfc
@@ -40,18 +48,17 @@ namespace withfc
         auto fc_handles() { return fc::make_tuple(&links); }
 
         std::size_t id;
-        std::size_t numLinks;
         bool visited;
-        fc::AdjacentArray<Node*> links;
+        fc::SizedArray<Node*> links;
 
-        static auto make_unique(std::size_t id, std::size_t numLinks, bool visited, std::size_t size)
+        static auto make_unique(std::size_t id, bool visited, std::size_t size)
         {
-            return fc::make_unique<Node>(size)(id, numLinks, visited);
+            return fc::make_unique<Node>(size)(id, visited);
         }
     };
 
     auto& getVisited(Node* n) { return n->visited; }
-    auto  getNumLinks(Node* n) { return n->numLinks; }
+    auto  getNumLinks(Node* n) { return n->links.size(); }
     auto  getLinks(Node* n) { return n->links.begin(n); }
 
     struct Dag
@@ -59,13 +66,34 @@ namespace withfc
         using N = Node;
         std::vector<fc::unique_ptr<Node>> nodes;
     };
+
+    auto addNode(Dag& g, std::size_t id, std::size_t numLinks)
+    {
+        g.nodes.push_back(Node::make_unique(id, false, numLinks));
+        return g.nodes.back().get();
+    }
+
+    auto getNode(Dag& g, std::size_t i) { return g.nodes[i].get(); }
+
+    // Same nodes, stored back-to-back in a flex_vector
+    struct PackedDag
+    {
+        using N = Node;
+        fc::flex_vector<Node> nodes;
+    };
+
+    auto addNode(PackedDag& g, std::size_t id, std::size_t numLinks)
+    {
+        return &g.nodes.emplace_back(numLinks)(id, false);
+    }
+
+    auto getNode(PackedDag& g, std::size_t i) { return &g.nodes[i]; }
 }
 
 namespace {
     template<class Dag>
     Dag makeRandomDag(std::size_t numNodes, int* inRands)
     {
-        using Node = typename Dag::N;
         Dag g;
         g.nodes.reserve(numNodes);
 
@@ -77,17 +105,15 @@ namespace {
 
             std::size_t numLinks = gSize ? (((*rands++) % gSize % 20) + 1) : 0;
 
-            auto n = Node::make_unique(g.nodes.size(), numLinks, false, numLinks);
+            auto n = addNode(g, gSize, numLinks);
 
-            auto b = getLinks(n.get());
+            auto b = getLinks(n);
             for (std::size_t l = 0; l < numLinks; ++l)
-                b[l] = g.nodes[(*rands++) % gSize].get();
+                b[l] = getNode(g, (*rands++) % gSize);
 
             // Force a connection with the last node
             if (numLinks)
-                b[numLinks-1] = g.nodes.back().get();
-
-            g.nodes.push_back(std::move(n));
+                b[numLinks-1] = getNode(g, gSize - 1);
         }
 
         return g;
@@ -96,7 +122,7 @@ namespace {
     template<class Dag, class Fn>
     void traverseDag(Dag& g, Fn&& fn)
     {
-        std::vector toProcess {g.nodes.back().get()};
+        std::vector toProcess {getNode(g, g.nodes.size() - 1)};
         toProcess.reserve(g.nodes.size());
 
         while (!toProcess.empty())
@@ -115,7 +141,7 @@ namespace {
                     toProcess.push_back(*b);
         }
 
-        for (auto& n : g.nodes) getVisited(n.get()) = false;
+        for (std::size_t i = 0; i < g.nodes.size(); ++i) getVisited(getNode(g, i)) = false;
     }
 }
 
@@ -130,6 +156,7 @@ TEST_CASE( "Test basic operations)", "[dag]")
 
     auto nofcDag = makeRandomDag<nofc::Dag>(dagSize, &randomNumbers.front());
     auto withfcDag = makeRandomDag<withfc::Dag>(dagSize, &randomNumbers.front());
+    auto packedDag = makeRandomDag<withfc::PackedDag>(dagSize, &randomNumbers.front());
 
     BENCHMARK("Sum all ids on nofc graph") {
         std::size_t sum = 0;
@@ -143,6 +170,12 @@ TEST_CASE( "Test basic operations)", "[dag]")
         return sum;
     };
 
+    BENCHMARK("Sum all ids on packed withfc graph") {
+        std::size_t sum = 0;
+        for (auto& n : packedDag.nodes) sum += n.id;
+        return sum;
+    };
+
     BENCHMARK("Sum all link ptrs on nofc graph") {
         std::size_t sum = 0;
         for (auto& n : nofcDag.nodes) sum += (std::uintptr_t) getLinks(n.get());
@@ -154,6 +187,12 @@ TEST_CASE( "Test basic operations)", "[dag]")
         for (auto& n : withfcDag.nodes) sum += (std::uintptr_t) getLinks(n.get());
         return sum;
     };
+
+    BENCHMARK("Sum all link ptrs on packed withfc graph") {
+        std::size_t sum = 0;
+        for (auto& n : packedDag.nodes) sum += (std::uintptr_t) getLinks(&n);
+        return sum;
+    };
 }
 
 TEST_CASE( "Create a large random DAG (Directed Acyclic Graph)", "[dag]")
@@ -168,6 +207,7 @@ TEST_CASE( "Create a large random DAG (Directed Acyclic Graph)", "[dag]")
     // Warm up
     { makeRandomDag<nofc::Dag>(dagSize, &randomNumbers.front()); }
     { makeRandomDag<withfc::Dag>(dagSize, &randomNumbers.front()); }
+    { makeRandomDag<withfc::PackedDag>(dagSize, &randomNumbers.front()); }
 
     BENCHMARK("Create DAG no fc") {
         return makeRandomDag<nofc::Dag>(dagSize, &randomNumbers.front());
@@ -177,8 +217,13 @@ TEST_CASE( "Create a large random DAG (Directed Acyclic Graph)", "[dag]")
         return makeRandomDag<withfc::Dag>(dagSize, &randomNumbers.front());
     };
 
+    BENCHMARK("Create packed DAG with fc") {
+        return makeRandomDag<withfc::PackedDag>(dagSize, &randomNumbers.front());
+    };
+
     auto nofcDag = makeRandomDag<nofc::Dag>(dagSize, &randomNumbers.front());
     auto withfcDag = makeRandomDag<withfc::Dag>(dagSize, &randomNumbers.front());
+    auto packedDag = makeRandomDag<withfc::PackedDag>(dagSize, &randomNumbers.front());
 
     BENCHMARK("Traverse DAG no fc") {
         int cnt = 0;
@@ -191,4 +236,10 @@ TEST_CASE( "Create a large random DAG (Directed Acyclic Graph)", "[dag]")
         traverseDag(withfcDag, [&cnt] (auto) { cnt++; });
         return cnt;
     };
+
+    BENCHMARK("Traverse packed DAG with fc") {
+        int cnt = 0;
+        traverseDag(packedDag, [&cnt] (auto) { cnt++; });
+        return cnt;
+    };
 }
@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch.hpp>
+#include <flexclass.hpp>
+
+namespace
+{
+    // Constructors are noexcept: fc::make builds it without rollback bookkeeping
+    struct Node
+    {
+        Node(std::size_t id) noexcept : id(id) {}
+        auto fc_handles() { return fc::make_tuple(&links, &weights); }
+
+        std::size_t id;
+        fc::Range<Node*> links;
+        fc::Range<float> weights;
+    };
+
+    // Same layout, but the constructor may throw: fc::make keeps the rollback path
+    struct MayThrowNode
+    {
+        MayThrowNode(std::size_t id) : id(id) {}
+        auto fc_handles() { return fc::make_tuple(&links, &weights); }
+
+        std::size_t id;
+        fc::Range<MayThrowNode*> links;
+        fc::Range<float> weights;
+    };
+
+    using NoIt = fc::Arg<fc::detail::NoIterator>;
+    static_assert(fc::isNothrowMakeable<Node, fc::tuple<NoIt, NoIt>, std::size_t>::value);
+    static_assert(!fc::isNothrowMakeable<MayThrowNode, fc::tuple<NoIt, NoIt>, std::size_t>::value);
+
+    template<class N>
+    std::size_t makeNodes(fc::Arena& arena, std::size_t numNodes)
+    {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < numNodes; ++i)
+        {
+            auto n = fc::make<N>(fc::withAllocator, arena, i % 4, i % 4)(i);
+            sum += (std::uintptr_t) n->links.end();
+        }
+        arena.reset();
+        return sum;
+    }
+}
+
+TEST_CASE( "fc::make latency for small nodes", "[make]")
+{
+    static constexpr std::size_t numNodes = 10000;
+
+    fc::Arena arena;
+
+    // Warm up
+    makeNodes<Node>(arena, numNodes);
+    makeNodes<MayThrowNode>(arena, numNodes);
+
+    BENCHMARK("Make small nodes with rollback bookkeeping") {
+        return makeNodes<MayThrowNode>(arena, numNodes);
+    };
+
+    BENCHMARK("Make small nodes on the noexcept path") {
+        return makeNodes<Node>(arena, numNodes);
+    };
+}
+
+namespace
+{
+    struct Row
+    {
+        auto fc_handles() { return fc::make_tuple(&cells); }
+
+        std::size_t id;
+        fc::AdjacentArray<double> cells;
+    };
+
+    static constexpr std::size_t rowWidth = 8;
+
+    double sumRows(fc::batch<Row>& rows)
+    {
+        double sum = 0;
+        for (auto& r : rows)
+            sum += r.cells.begin(&r)[rowWidth - 1];
+        return sum;
+    }
+
+    double sumRows(std::vector<fc::unique_ptr<Row>>& rows)
+    {
+        double sum = 0;
+        for (auto& r : rows)
+            sum += r->cells.begin(r.get())[rowWidth - 1];
+        return sum;
+    }
+}
+
+TEST_CASE( "Batch construction of same-shaped objects", "[make_n]")
+{
+    static constexpr std::size_t numRows = 10000;
+
+    BENCHMARK("Make rows one by one") {
+        std::vector<fc::unique_ptr<Row>> rows;
+        rows.reserve(numRows);
+        for (std::size_t i = 0; i < numRows; ++i)
+            rows.push_back(fc::make_unique<Row>(fc::fill(rowWidth, 1.0))(i));
+        return rows.size();
+    };
+
+    BENCHMARK("Make rows with fc::make_n") {
+        auto rows = fc::make_n<Row>(numRows, fc::fill(rowWidth, 1.0))(std::size_t(0));
+        auto size = rows.size();
+        fc::destroy_n(rows);
+        return size;
+    };
+
+    std::vector<fc::unique_ptr<Row>> rows;
+    for (std::size_t i = 0; i < numRows; ++i)
+        rows.push_back(fc::make_unique<Row>(fc::fill(rowWidth, 1.0))(i));
+    auto batch = fc::make_n<Row>(numRows, fc::fill(rowWidth, 1.0))(std::size_t(0));
+
+    BENCHMARK("Traverse rows made one by one") {
+        return sumRows(rows);
+    };
+
+    BENCHMARK("Traverse rows made with fc::make_n") {
+        return sumRows(batch);
+    };
+
+    fc::destroy_n(batch);
+}
@@ -0,0 +1,70 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch.hpp>
+#include <flexclass.hpp>
+
+#include <vector>
+
+namespace
+{
+    // Adjacency list of node indices stored in 64 bit slots
+    struct WideNode
+    {
+        auto fc_handles() { return fc::make_tuple(&links); }
+
+        std::size_t id;
+        fc::Range<std::uint64_t> links;
+    };
+
+    // Same indices in 20 bits each
+    struct PackedNode
+    {
+        auto fc_handles() { return fc::make_tuple(&links); }
+
+        std::size_t id;
+        fc::PackedIntArray<20> links;
+    };
+
+    static constexpr std::size_t numLinks = 1 << 16;
+
+    std::vector<std::uint64_t> makeIndices()
+    {
+        std::vector<std::uint64_t> indices(numLinks);
+        for (std::size_t i = 0; i < numLinks; ++i)
+            indices[i] = (i * 7919) % (1 << 20);
+        return indices;
+    }
+}
+
+TEST_CASE( "Decoding bit-packed integers", "[packed]")
+{
+    auto indices = makeIndices();
+    auto wide = fc::make_unique<WideNode>(fc::arg(numLinks, indices.begin()))(std::size_t(0));
+    auto packed = fc::make_unique<PackedNode>(fc::arg(numLinks, indices.begin()))(std::size_t(0));
+
+    CHECK(fc::allocated_size(packed.get()) * 3 < fc::allocated_size(wide.get()));
+
+    std::vector<std::uint32_t> buffer(numLinks);
+
+    BENCHMARK("Sum 64 bit indices") {
+        std::uint64_t sum = 0;
+        for (auto it = wide->links.begin(); it != wide->links.end(); ++it)
+            sum += *it;
+        return sum;
+    };
+
+    BENCHMARK("Sum packed indices one by one") {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < numLinks; ++i)
+            sum += packed->links.get(i);
+        return sum;
+    };
+
+    BENCHMARK("Sum packed indices decoded in bulk") {
+        packed->links.decode(buffer.data(), 0, numLinks);
+        std::uint64_t sum = 0;
+        for (auto v : buffer)
+            sum += v;
+        return sum;
+    };
+}
@@ -2,6 +2,12 @@
 #include <flexclass.hpp>
 
 #include <cstring>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 TEST_CASE( "Empty class", "[Edge cases]" )
 {
@@ -519,3 +525,1147 @@ TEST_CASE( "Support initialization of arrays" , "[basic]" )
     m = fc::make_unique<Message>(fc::arg(10, v.begin()))(10);
     CHECK( std::equal(v.begin(), v.end(), m->a1.begin()) );
 }
+
+TEST_CASE( "Over-aligned array elements", "[alignment]" )
+{
+    struct alignas(64) CacheLine
+    {
+        int value;
+    };
+
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&chars, &lines); }
+        char c;
+        fc::Range<char> chars;
+        fc::Range<CacheLine> lines;
+    };
+
+    static_assert(fc::layoutAlignment<Message>::value == 64);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        auto m = fc::make_unique<Message>(i + 1, 10)('a');
+        CHECK((std::uintptr_t)m.get() % 64 == 0);
+        CHECK((std::uintptr_t)m->lines.begin() % 64 == 0);
+        for (auto& l : m->lines)
+            l.value = i;
+        CHECK(m->lines.begin()[9].value == i);
+    }
+
+    fc::Arena arena;
+    for (int i = 0; i < 10; ++i)
+    {
+        auto m = fc::make<Message>(fc::withAllocator, arena, i + 1, 10)('a');
+        CHECK((std::uintptr_t)m % 64 == 0);
+        CHECK((std::uintptr_t)m->lines.begin() % 64 == 0);
+    }
+}
+
+TEST_CASE( "Over-aligned base", "[alignment]" )
+{
+    struct alignas(128) Message
+    {
+        auto fc_handles() { return fc::make_tuple(&ints); }
+        fc::AdjacentRange<int> ints;
+    };
+
+    auto m = fc::make_unique<Message>(10)();
+    CHECK((std::uintptr_t)m.get() % 128 == 0);
+    CHECK((std::uintptr_t)m->ints.begin(m.get()) - (std::uintptr_t)m.get() == sizeof(Message));
+}
+
+TEST_CASE( "AlignedArray<T, N> and AlignedRange<T, N> start on the requested boundary", "[alignment]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&chars, &floats, &doubles); }
+        char c;
+        fc::Range<char> chars;
+        fc::AlignedArray<float, 64> floats;
+        fc::AlignedRange<double, 32> doubles;
+    };
+
+    static_assert(fc::layoutAlignment<Message>::value == 64);
+
+    for (int i = 0; i < 70; ++i)
+    {
+        auto m = fc::make_unique<Message>(i, 3, i)('a');
+        CHECK((std::uintptr_t)m->floats.begin() % 64 == 0);
+        CHECK((std::uintptr_t)m->doubles.begin() % 32 == 0);
+        CHECK(m->doubles.end() - m->doubles.begin() == i);
+        CHECK((std::uintptr_t)m->floats.begin() >= (std::uintptr_t)m->chars.end());
+        CHECK((std::uintptr_t)m->doubles.begin() >= (std::uintptr_t)(m->floats.begin() + 3));
+        std::fill(m->doubles.begin(), m->doubles.end(), 1.0);
+    }
+}
+
+TEST_CASE( "Bulk initialization of trivially copyable arrays" , "[basic]" )
+{
+    static_assert(fc::is_contiguous_iterator<int*>::value);
+    static_assert(fc::is_contiguous_iterator<std::vector<int>::const_iterator>::value);
+    static_assert(fc::is_contiguous_iterator<std::string::iterator>::value);
+    static_assert(!fc::is_contiguous_iterator<std::vector<bool>::iterator>::value);
+    static_assert(!fc::is_contiguous_iterator<std::list<int>::iterator>::value);
+
+    static_assert(fc::ArrayBuilder<int>::isBulkInitializable<fc::detail::NoIterator>());
+    static_assert(fc::ArrayBuilder<int>::isBulkInitializable<std::vector<int>::iterator>());
+    static_assert(fc::ArrayBuilder<int>::isBulkInitializable<fc::detail::Fill<int>>());
+    static_assert(!fc::ArrayBuilder<int>::isBulkInitializable<std::vector<short>::iterator>());
+    static_assert(!fc::ArrayBuilder<std::string>::isBulkInitializable<std::string*>());
+
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&ints, &chars); }
+        fc::Range<int> ints;
+        fc::Range<char> chars;
+    };
+
+    std::vector<int> v(1000);
+    std::iota(v.begin(), v.end(), 0);
+    std::string str = "some characters";
+
+    // memcpy from contiguous iterators
+    auto m = fc::make_unique<Message>(fc::arg(v.size(), v.cbegin()), fc::arg(str.size(), str.data()))();
+    CHECK(std::equal(v.begin(), v.end(), m->ints.begin(), m->ints.end()));
+    CHECK(std::string(m->chars.begin(), m->chars.end()) == str);
+
+    // Element by element from other iterators
+    std::list<int> l(v.begin(), v.end());
+    m = fc::make_unique<Message>(fc::arg(l.size(), l.begin()), fc::arg(0, str.data()))();
+    CHECK(std::equal(l.begin(), l.end(), m->ints.begin(), m->ints.end()));
+    CHECK(m->chars.begin() == m->chars.end());
+
+    // Fill
+    m = fc::make_unique<Message>(fc::fill(100, 42), fc::fill(10, 'x'))();
+    CHECK(std::all_of(m->ints.begin(), m->ints.end(), [](int i) { return i == 42; }));
+    CHECK(std::string(m->chars.begin(), m->chars.end()) == "xxxxxxxxxx");
+
+    // Both paths leave the iterator past the elements, so a reused fc::make continues from there
+    struct Pair
+    {
+        auto fc_handles() { return fc::make_tuple(&copied, &constructed); }
+        fc::Range<int> copied;
+        fc::Range<int> constructed;
+    };
+
+    auto make = fc::make<Pair>(fc::arg(3, v.cbegin()), fc::arg(3, l.begin()));
+    auto first = make();
+    auto second = make();
+    CHECK(second->copied.begin()[0] == 3);
+    CHECK(second->constructed.begin()[0] == 3);
+    fc::destroy(first);
+    fc::destroy(second);
+}
+
+TEST_CASE( "fc::fill with non-trivial type" , "[basic]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&strings); }
+        fc::Range<std::string> strings;
+    };
+
+    auto str = "This is a rather long string to make sure it allocates";
+    auto m = fc::make_unique<Message>(fc::fill(10, str))();
+    CHECK(m->strings.end() - m->strings.begin() == 10);
+    CHECK(std::all_of(m->strings.begin(), m->strings.end(), [&](auto& s) { return s == str; }));
+}
+
+TEST_CASE( "Strong exception guarantees when filling an array", "[exception]" )
+{
+    resetToThrowAt(5);
+
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&a1); }
+        fc::Range<Thrower> a1;
+    };
+
+    try
+    {
+        auto m = fc::make_unique<Message>(fc::fill(10, "thrower"))();
+    }
+    catch (std::runtime_error& err)
+    {
+        CHECK(std::string("5") == err.what());
+    }
+    checkReset();
+}
+
+TEST_CASE( "Types that cannot throw on construction take the noexcept path", "[exception]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links, &weights); }
+        std::size_t id;
+        fc::Range<Node*> links;
+        fc::Range<double> weights;
+    };
+
+    struct NamedNode
+    {
+        auto fc_handles() { return fc::make_tuple(&names); }
+        fc::Range<std::string> names;
+    };
+
+    struct ThrowingCtor
+    {
+        ThrowingCtor(int i) : i(i) {}
+        auto fc_handles() { return fc::make_tuple(&ints); }
+        int i;
+        fc::Range<int> ints;
+    };
+
+    using NoIt = fc::Arg<fc::detail::NoIterator>;
+    using VecIt = fc::Arg<std::vector<double>::iterator>;
+    static_assert(fc::isNothrowMakeable<Node, fc::tuple<NoIt, NoIt>, std::size_t>::value);
+    static_assert(fc::isNothrowMakeable<Node, fc::tuple<NoIt, VecIt>, std::size_t>::value);
+    using FillStr = fc::Arg<fc::detail::Fill<const char*>>;
+    static_assert(fc::isNothrowMakeable<NamedNode, fc::tuple<NoIt>>::value);
+    static_assert(!fc::isNothrowMakeable<NamedNode, fc::tuple<FillStr>>::value);
+    static_assert(!fc::isNothrowMakeable<ThrowingCtor, fc::tuple<NoIt>, int>::value);
+
+    std::vector<double> w {1.0, 2.0, 3.0};
+    auto n = fc::make_unique<Node>(2, fc::arg(w.size(), w.begin()))(std::size_t(7));
+    CHECK(n->id == 7);
+    CHECK(n->links.end() - n->links.begin() == 2);
+    CHECK(std::equal(w.begin(), w.end(), n->weights.begin(), n->weights.end()));
+}
+
+TEST_CASE( "Arrays with compile time sizes have a compile time layout", "[static]" )
+{
+    struct BTreeNode
+    {
+        auto fc_handles() { return fc::make_tuple(&keys, &children); }
+        std::uint16_t numKeys;
+        fc::AdjacentArray<std::int32_t> keys;
+        fc::Range<BTreeNode*> children;
+    };
+
+    using Layout = fc::static_layout<BTreeNode, 16, 17>;
+    static_assert(Layout::offsets[0] == sizeof(BTreeNode));
+    static_assert(Layout::offsets[1] ==
+                  fc::findNextAlignedPosition(sizeof(BTreeNode) + 16 * 4, alignof(BTreeNode*)));
+    static_assert(Layout::bytes == Layout::offsets[1] + 17 * sizeof(BTreeNode*));
+    static_assert(Layout::alignment == alignof(BTreeNode));
+
+    using Args = decltype(fc::args(fc::static_size<16>, fc::static_size<17>));
+    static_assert(fc::hasStaticLayout<BTreeNode, Args>::value);
+    static_assert(!fc::hasStaticLayout<BTreeNode, decltype(fc::args(16, fc::static_size<17>))>::value);
+
+    std::int32_t ks[16];
+    std::iota(std::begin(ks), std::end(ks), 100);
+
+    auto n = fc::make_unique<BTreeNode>(fc::arg(fc::static_size<16>, std::begin(ks)),
+                                        fc::static_size<17>)(std::uint16_t(16));
+    auto base = reinterpret_cast<std::byte*>(n.get());
+    CHECK(reinterpret_cast<std::byte*>(n->keys.begin(n.get())) == base + Layout::offsets[0]);
+    CHECK(reinterpret_cast<std::byte*>(n->children.begin()) == base + Layout::offsets[1]);
+    CHECK(reinterpret_cast<std::byte*>(n->children.end()) == base + Layout::bytes);
+    CHECK(std::equal(std::begin(ks), std::end(ks), n->keys.begin(n.get())));
+
+    // The same layout is computed at runtime from dynamic sizes
+    auto d = fc::make_unique<BTreeNode>(16, 17)(std::uint16_t(16));
+    CHECK(fc::allocationSize(d.get()) == Layout::bytes);
+}
+
+TEST_CASE( "fc::layout_of computes the layout without creating the object", "[layout]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&id, &links, &weights); }
+        char tag;
+        fc::AdjacentArray<char> id;
+        fc::Range<Node*> links;
+        fc::AlignedRange<float, 64> weights;
+    };
+
+    auto layout = fc::layout_of<Node>(5, 3, fc::fill(7, 1.f));
+    static_assert(std::is_same_v<decltype(layout.offsets), std::array<std::size_t, 3>>);
+    CHECK(layout.alignment == 64);
+    CHECK(layout.offsets[0] == sizeof(Node));
+    CHECK(layout.offsets[1] % alignof(Node*) == 0);
+    CHECK(layout.offsets[2] % 64 == 0);
+    CHECK(layout.bytes == layout.offsets[2] + 7 * sizeof(float));
+
+    auto n = fc::make_unique<Node>(5, 3, fc::fill(7, 1.f))('x');
+    auto base = reinterpret_cast<std::byte*>(n.get());
+    CHECK(reinterpret_cast<std::byte*>(n->id.begin(n.get())) == base + layout.offsets[0]);
+    CHECK(reinterpret_cast<std::byte*>(n->links.begin()) == base + layout.offsets[1]);
+    CHECK(reinterpret_cast<std::byte*>(n->weights.begin()) == base + layout.offsets[2]);
+    CHECK(fc::allocated_size(static_cast<const Node*>(n.get())) == layout.bytes);
+
+    // Static sizes give the same layout
+    auto s = fc::layout_of<Node>(fc::static_size<5>, fc::static_size<3>, fc::static_size<7>);
+    CHECK(s.bytes == layout.bytes);
+    CHECK(s.offsets == layout.offsets);
+}
+
+TEST_CASE( "fc::make_at creates objects in a caller-provided buffer", "[make_at]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&payload, &tags); }
+        std::uint32_t id;
+        fc::AdjacentArray<char> payload;
+        fc::Range<std::string> tags;
+    };
+
+    auto layout = fc::layout_of<Message>(16, 2);
+    alignas(Message) std::byte buffer[512];
+
+    std::string tags[] = {"urgent", "io"};
+    auto m = fc::make_at<Message>(buffer, sizeof(buffer), 16, fc::arg(2, std::begin(tags)))(42u);
+    CHECK(reinterpret_cast<std::byte*>(m) == buffer);
+    CHECK(m->id == 42);
+    CHECK(m->tags.begin()[1] == "io");
+    CHECK(fc::allocated_size(m) == layout.bytes);
+    fc::destroy_at(m);
+
+    // Exactly the size of the layout fits
+    m = fc::make_at<Message>(buffer, layout.bytes, 16, 2)(1u);
+    CHECK(m->tags.end() - m->tags.begin() == 2);
+    fc::destroy_at(m);
+
+    // The object is aligned inside the buffer, and the padding counts against the capacity
+    auto misaligned = buffer + 1;
+    m = fc::make_at<Message>(misaligned, layout.bytes + alignof(Message) - 1, 16, 2)(2u);
+    CHECK(reinterpret_cast<std::byte*>(m) == buffer + alignof(Message));
+    fc::destroy_at(m);
+
+    CHECK_THROWS_AS(fc::make_at<Message>(buffer, layout.bytes - 1, 16, 2)(3u), std::bad_alloc);
+    CHECK_THROWS_AS(fc::make_at<Message>(misaligned, layout.bytes, 16, 2)(3u), std::bad_alloc);
+}
+
+TEST_CASE( "fc::inline_storage keeps small objects off the heap", "[inline]" )
+{
+    struct Query
+    {
+        auto fc_handles() { return fc::make_tuple(&terms); }
+        int op;
+        fc::Range<std::string> terms;
+    };
+
+    std::string terms[] = {"flexible", "array", "members"};
+
+    auto small = fc::make_inline<Query, 256>(fc::arg(3, std::begin(terms)))(1);
+    CHECK(small.isInline());
+    CHECK(small->op == 1);
+    CHECK((*small).terms.begin()[2] == "members");
+    CHECK(fc::allocated_size(small.get()) <= 256);
+
+    auto large = fc::make_inline<Query, 64>(10)(2);
+    CHECK(!large.isInline());
+    CHECK(large->op == 2);
+    CHECK(large->terms.end() - large->terms.begin() == 10);
+
+    // Exactly the size of the layout fits
+    static constexpr std::size_t bytes = fc::static_layout<Query, 3>::bytes;
+    auto exact = fc::make_inline<Query, bytes>(fc::static_size<3>)(3);
+    CHECK(exact.isInline());
+}
+
+TEST_CASE( "fc::make_n creates objects back-to-back in a single allocation", "[make_n]" )
+{
+    struct Row
+    {
+        auto fc_handles() { return fc::make_tuple(&cells, &labels); }
+        std::uint8_t flags;
+        fc::AdjacentArray<double> cells;
+        fc::Range<std::string> labels;
+    };
+
+    std::vector<double> init {1., 2., 3., 4.};
+    auto rows = fc::make_n<Row>(100, fc::arg(4, init.begin()), fc::fill(2, "label"))(std::uint8_t(7));
+
+    auto layout = fc::layout_of<Row>(4, 2);
+    CHECK(rows.size() == 100);
+    CHECK(rows.stride() == fc::findNextAlignedPosition(layout.bytes, alignof(Row)));
+
+    std::size_t count = 0;
+    for (auto& r : rows)
+    {
+        CHECK(reinterpret_cast<std::byte*>(&r) == rows.data() + count * rows.stride());
+        CHECK(r.flags == 7);
+        // Every object is created from the same initial arguments
+        CHECK(std::equal(init.begin(), init.end(), r.cells.begin(&r)));
+        CHECK(r.labels.begin()[1] == "label");
+        ++count;
+    }
+    CHECK(count == 100);
+    CHECK(&rows[99] == &*std::next(rows.begin(), 99));
+
+    fc::destroy_n(rows);
+}
+
+TEST_CASE( "fc::make_n destroys the objects already created on exceptions", "[make_n][exception]" )
+{
+    static int alive = 0;
+    static int created = 0;
+    struct Counted
+    {
+        Counted()
+        {
+            if (++created == 10)
+                throw std::runtime_error("Oops");
+            ++alive;
+        }
+        ~Counted() { --alive; }
+    };
+
+    struct Bag
+    {
+        auto fc_handles() { return fc::make_tuple(&items); }
+        fc::Range<Counted> items;
+    };
+
+    CHECK_THROWS_AS(fc::make_n<Bag>(5, 3)(), std::runtime_error);
+    CHECK(alive == 0);
+
+    created = -100;
+    auto bags = fc::make_n<Bag>(5, 3)();
+    CHECK(alive == 15);
+    fc::destroy_n(bags);
+    CHECK(alive == 0);
+
+    // The size of the allocation would overflow
+    CHECK_THROWS_AS(fc::make_n<Bag>(std::size_t(-1) / sizeof(Bag), 3)(), std::bad_array_new_length);
+    CHECK(alive == 0);
+}
+
+TEST_CASE( "Offset handles are small and position independent", "[offset]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&ids, &weights); }
+        std::uint32_t id;
+        fc::OffsetArray<std::uint32_t, std::uint16_t> ids;
+        fc::OffsetRange<float, std::uint16_t> weights;
+    };
+
+    static_assert(sizeof(fc::OffsetArray<int, std::uint16_t>) == 2);
+    static_assert(sizeof(fc::OffsetRange<int, std::uint16_t>) == 4);
+    static_assert(sizeof(fc::OffsetRange<int>) == 8);
+    static_assert(sizeof(Node) == 12);
+    static_assert(fc::is_trivially_relocatable_v<Node>);
+
+    std::vector<std::uint32_t> ids {1, 2, 3};
+    alignas(Node) std::byte copy[128];
+    std::size_t bytes;
+    {
+        auto n = fc::make_unique<Node>(fc::arg(3, ids.begin()), fc::fill(4, 0.25f))(7u);
+        CHECK(std::equal(ids.begin(), ids.end(), n->ids.begin()));
+        CHECK(n->weights.size() == 4);
+        CHECK(std::count(n->weights.begin(), n->weights.end(), 0.25f) == 4);
+
+        // A plain copy of the bytes is a valid object
+        bytes = fc::allocated_size(n.get());
+        REQUIRE(bytes <= sizeof(copy));
+        std::memcpy(copy, n.get(), bytes);
+    }
+
+    auto c = reinterpret_cast<Node*>(copy);
+    CHECK(c->id == 7);
+    CHECK(std::equal(ids.begin(), ids.end(), c->ids.begin()));
+    CHECK(reinterpret_cast<std::byte*>(c->weights.end()) == copy + bytes);
+}
+
+TEST_CASE( "Offsets and sizes that don't fit in an offset handle are rejected", "[offset]" )
+{
+    struct Packet
+    {
+        auto fc_handles() { return fc::make_tuple(&header, &payload); }
+        fc::OffsetArray<char, std::uint8_t> header;
+        fc::OffsetRange<char, std::uint8_t> payload;
+    };
+
+    auto p = fc::make_unique<Packet>(fc::fill(200, 'h'), fc::fill(50, 'p'))();
+    CHECK(p->header.begin()[199] == 'h');
+    CHECK(p->payload.size() == 50);
+    CHECK(p->payload.begin()[0] == 'p');
+
+    // The payload starts too far from its handle
+    CHECK_THROWS_AS(fc::layout_of<Packet>(300, 0), std::length_error);
+    CHECK_THROWS_AS(fc::make_unique<Packet>(300, 0)(), std::length_error);
+    // The payload has too many elements
+    CHECK_THROWS_AS(fc::make_unique<Packet>(0, 256)(), std::length_error);
+}
+
+TEST_CASE( "SizedArray stores only the number of elements", "[sized]" )
+{
+    static int alive = 0;
+    struct Counted
+    {
+        Counted() { ++alive; }
+        ~Counted() { --alive; }
+    };
+
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links, &items); }
+        std::uint32_t id;
+        fc::SizedArray<Node*, std::uint16_t> links;
+        fc::SizedArray<Counted, std::uint16_t, 0> items;
+    };
+
+    static_assert(sizeof(fc::SizedArray<int, std::uint16_t>) == 2);
+    static_assert(sizeof(Node) == 8);
+    static_assert(fc::knowsAllocationSize<Node>::value);
+
+    {
+        auto n = fc::make_unique<Node>(3, 5)(1u);
+        CHECK(n->links.size() == 3);
+        CHECK(n->items.size() == 5);
+        CHECK(alive == 5);
+
+        auto base = reinterpret_cast<std::byte*>(n.get());
+        auto layout = fc::layout_of<Node>(3, 5);
+        CHECK(reinterpret_cast<std::byte*>(n->links.begin(n.get())) == base + layout.offsets[0]);
+        CHECK(n->links.end(n.get()) - n->links.begin(n.get()) == 3);
+        CHECK(reinterpret_cast<std::byte*>(n->items.begin(n.get())) == base + layout.offsets[1]);
+        CHECK(fc::allocated_size(n.get()) == layout.bytes);
+    }
+    CHECK(alive == 0);
+
+    // Rejected before any element is created
+    CHECK_THROWS_AS(fc::make_unique<Node>(3, 70000)(1u), std::length_error);
+    CHECK(alive == 0);
+}
+
+TEST_CASE( "PrecedingArray places the array before the base", "[preceding]" )
+{
+    struct Use
+    {
+        int* value;
+    };
+
+    struct User
+    {
+        auto fc_handles() { return fc::make_tuple(&operands); }
+        fc::PrecedingArray<Use> operands;
+        std::uint32_t opcode;
+    };
+
+    static_assert(sizeof(User) == 8);
+
+    int a = 1, b = 2, c = 3;
+    Use uses[] = {{&a}, {&b}, {&c}};
+    auto u = fc::make_unique<User>(fc::arg(3, std::begin(uses)))(0u, 7u);
+    CHECK(u->opcode == 7);
+    CHECK(u->operands.size() == 3);
+    CHECK(u->operands.end(u.get()) == reinterpret_cast<Use*>(u.get()));
+    CHECK(u->operands.begin(u.get()) + 3 == u->operands.end(u.get()));
+    CHECK(*u->operands.begin(u.get())[2].value == 3);
+
+    auto layout = fc::layout_of<User>(3);
+    CHECK(layout.baseOffset == fc::findNextAlignedPosition(3 * sizeof(Use), alignof(User)));
+    CHECK(layout.offsets[0] == layout.baseOffset - 3 * sizeof(Use));
+    CHECK(layout.bytes == layout.baseOffset + sizeof(User));
+    CHECK(fc::allocated_size(u.get()) == layout.bytes);
+    CHECK(fc::allocationBegin(u.get()) == reinterpret_cast<std::byte*>(u.get()) - layout.baseOffset);
+
+    static_assert(fc::static_layout<User, 3>::baseOffset == 3 * sizeof(Use));
+}
+
+TEST_CASE( "Several arrays precede the base, followed by regular arrays", "[preceding]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&names, &flags, &weights, &tags); }
+        fc::PrecedingArray<std::string, std::uint16_t> names;
+        fc::PrecedingArray<char, std::uint16_t, 0> flags;
+        std::uint32_t id;
+        fc::Range<double> weights;
+        fc::AdjacentRange<std::string, 2> tags;
+    };
+
+    auto n = fc::make_unique<Node>(fc::fill(2, std::string(40, 'n')), fc::fill(3, 'f'),
+                                   fc::fill(4, 0.5), fc::fill(5, std::string(40, 't')))(
+        std::uint16_t(0), std::uint16_t(0), 9u);
+
+    auto base = reinterpret_cast<std::byte*>(n.get());
+    auto names = n->names.begin(n.get());
+    auto flags = n->flags.begin(n.get());
+    CHECK(reinterpret_cast<std::byte*>(names + 2) == base);
+    CHECK(reinterpret_cast<std::uintptr_t>(names) % alignof(std::string) == 0);
+    CHECK(flags + 3 <= reinterpret_cast<char*>(names));
+    CHECK(names[1] == std::string(40, 'n'));
+    CHECK(std::string(flags, flags + 3) == "fff");
+    CHECK(n->weights.begin()[3] == 0.5);
+    CHECK(n->tags.begin(n.get())[4] == std::string(40, 't'));
+
+    auto layout = fc::layout_of<Node>(2, 3, 4, 5);
+    auto mem = fc::allocationBegin(n.get());
+    CHECK(base == mem + layout.baseOffset);
+    CHECK(reinterpret_cast<std::byte*>(flags) == mem + layout.offsets[1]);
+    CHECK(reinterpret_cast<std::byte*>(n->weights.begin()) == mem + layout.offsets[2]);
+    CHECK(fc::allocated_size(n.get()) == layout.bytes);
+}
+
+TEST_CASE( "Sizes that don't fit in the size type of a PrecedingArray are rejected", "[preceding]" )
+{
+    struct User
+    {
+        auto fc_handles() { return fc::make_tuple(&operands); }
+        fc::PrecedingArray<char, std::uint8_t> operands;
+    };
+
+    auto u = fc::make_unique<User>(fc::fill(255, 'u'))();
+    CHECK(u->operands.size() == 255);
+    CHECK(u->operands.begin(u.get())[0] == 'u');
+
+    CHECK_THROWS_AS(fc::layout_of<User>(256), std::length_error);
+    CHECK_THROWS_AS(fc::make_unique<User>(300)(), std::length_error);
+}
+
+TEST_CASE( "Strong exception guarantees when a preceding array throws", "[preceding][exception]" )
+{
+    resetToThrowAt(7);
+
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&before, &after); }
+        fc::PrecedingArray<Thrower> before;
+        Thrower a;
+        fc::Range<Thrower> after;
+    };
+
+    try
+    {
+        auto m = fc::make_unique<Message>(5, 5)(0u, "");
+    }
+    catch (std::runtime_error& err)
+    {
+        CHECK(std::string("7") == err.what());
+    }
+    checkReset();
+}
+
+TEST_CASE( "Objects with preceding arrays are created in buffers and batches", "[preceding]" )
+{
+    struct User
+    {
+        auto fc_handles() { return fc::make_tuple(&operands); }
+        fc::PrecedingArray<std::uint64_t> operands;
+        std::uint32_t opcode;
+    };
+
+    alignas(User) std::byte buffer[64];
+    auto u = fc::make_at<User>(buffer, sizeof(buffer), fc::fill(2, std::uint64_t(5)))(0u, 1u);
+    CHECK(reinterpret_cast<std::byte*>(u) == buffer + 2 * sizeof(std::uint64_t));
+    CHECK(u->operands.begin(u)[0] == 5);
+    fc::destroy_at(u);
+
+    auto inl = fc::make_inline<User, 64>(fc::fill(2, std::uint64_t(6)))(0u, 2u);
+    CHECK(inl.isInline());
+    CHECK(inl->operands.begin(inl.get())[1] == 6);
+
+    auto users = fc::make_n<User>(4, fc::fill(3, std::uint64_t(7)))(0u, 3u);
+    for (auto& user : users)
+    {
+        CHECK(user.opcode == 3);
+        CHECK(user.operands.begin(&user)[2] == 7);
+    }
+    CHECK(reinterpret_cast<std::byte*>(&users[0]) == users.data() + 3 * sizeof(std::uint64_t));
+    fc::destroy_n(users);
+}
+
+TEST_CASE( "SortByAlignment lays arrays out by decreasing alignment", "[layout]" )
+{
+    struct Packet
+    {
+        using fc_layout_policy = fc::SortByAlignment;
+        auto fc_handles() { return fc::make_tuple(&flags, &values, &shorts, &more, &ids); }
+        char kind;
+        fc::Range<char> flags;
+        fc::Range<double> values;
+        fc::Range<std::uint16_t> shorts;
+        fc::AdjacentRange<char, 2> more;
+        fc::Range<std::uint32_t> ids;
+    };
+
+    CHECK(fc::layoutOrder<Packet>::value == std::array<int, 5>{1, 4, 2, 3, 0});
+    CHECK(fc::layoutOrder<Packet, fc::HandleOrder>::value == std::array<int, 5>{0, 1, 2, 3, 4});
+    static_assert(fc::knowsAllocationSize<Packet>::value);
+
+    auto p = fc::make_unique<Packet>(fc::fill(3, 'f'), fc::fill(2, 1.5),
+                                     fc::fill(3, std::uint16_t(2)), fc::fill(1, 'm'),
+                                     fc::fill(5, 7u))('k');
+    CHECK(p->kind == 'k');
+    CHECK(std::string(p->flags.begin(), p->flags.end()) == "fff");
+    CHECK(p->values.begin()[1] == 1.5);
+    CHECK(p->shorts.begin()[2] == 2);
+    CHECK(p->more.begin(p.get())[0] == 'm');
+    CHECK(p->ids.begin()[4] == 7);
+
+    auto base = reinterpret_cast<std::byte*>(p.get());
+    auto layout = fc::layout_of<Packet>(3, 2, 3, 1, 5);
+    CHECK(reinterpret_cast<std::byte*>(p->values.begin()) == base + layout.offsets[1]);
+    CHECK(layout.offsets[1] < layout.offsets[4]);
+    CHECK(layout.offsets[4] < layout.offsets[2]);
+    CHECK(reinterpret_cast<std::byte*>(p->shorts.end()) == base + layout.offsets[3]);
+    CHECK(reinterpret_cast<std::byte*>(p->flags.end()) == base + layout.bytes);
+    CHECK(fc::allocated_size(p.get()) == layout.bytes);
+
+    // Padding before the doubles and the ints in handle order: 3 + 5 + 16 + 6 + 1 + 1 + 20
+    auto sizes = fc::arraySizes<Packet>(fc::args(3, 2, 3, 1, 5));
+    CHECK(fc::layoutFromSizes<Packet, fc::HandleOrder>(sizes).bytes == sizeof(Packet) + 52);
+    CHECK(layout.bytes == sizeof(Packet) + 16 + 20 + 6 + 1 + 3);
+    CHECK(layout.paddingSaved == 6);
+    CHECK(fc::layout_of<Packet>(0, 0, 0, 0, 0).paddingSaved == 0);
+}
+
+TEST_CASE( "SoA lays out parallel columns from a single size", "[soa]" )
+{
+    struct Particles
+    {
+        auto fc_handles() { return fc::make_tuple(&data, &names); }
+        std::uint32_t id;
+        fc::SoA<std::uint8_t, double, std::uint16_t> data;
+        fc::AdjacentRange<char, 0> names;
+    };
+
+    static_assert(sizeof(fc::SoA<int, float, bool>) == 16);
+    static_assert(fc::handleAlignment<fc::SoA<std::uint8_t, double>>::value == alignof(double));
+
+    auto p = fc::make_unique<Particles>(5, fc::fill(3, 'n'))(1u);
+    REQUIRE(p->data.size() == 5);
+
+    auto kinds = p->data.column<0>();
+    auto weights = p->data.column<1>();
+    auto counts = p->data.column<2>();
+    static_assert(std::is_same_v<decltype(weights), fc::span<double>>);
+    CHECK(kinds.size() == 5);
+    CHECK(weights.size() == 5);
+    CHECK(reinterpret_cast<std::uintptr_t>(weights.data()) % alignof(double) == 0);
+
+    // The columns follow each other, each one aligned for its type
+    auto begin = p->data.begin(p.get());
+    CHECK(reinterpret_cast<std::byte*>(kinds.data()) == begin);
+    CHECK(reinterpret_cast<std::byte*>(weights.data()) == begin + 8);
+    CHECK(reinterpret_cast<std::byte*>(counts.data()) == begin + 8 + 5 * sizeof(double));
+    CHECK(p->data.end(p.get()) == begin + 8 + 5 * sizeof(double) + 5 * sizeof(std::uint16_t));
+    CHECK(reinterpret_cast<std::byte*>(p->names.begin(p.get())) == p->data.end(p.get()));
+
+    std::iota(weights.begin(), weights.end(), 0.5);
+    std::fill(counts.begin(), counts.end(), std::uint16_t(7));
+    CHECK(std::accumulate(weights.begin(), weights.end(), 0.0) == 12.5);
+    CHECK(p->names.begin(p.get())[2] == 'n');
+    CHECK(fc::allocated_size(p.get()) == fc::layout_of<Particles>(5, 3).bytes);
+
+    auto z = fc::make_unique<Particles>(fc::zeroed(9), 0)(2u);
+    auto zc = z->data.column<2>();
+    CHECK(std::all_of(zc.begin(), zc.end(), [](auto c) { return c == 0; }));
+    CHECK(z->data.column<1>()[8] == 0.0);
+
+    auto e = fc::make_unique<Particles>(0, 0)(3u);
+    CHECK(e->data.size() == 0);
+    CHECK(e->data.column<1>().empty());
+}
+
+TEST_CASE( "SoA objects can be relocated", "[soa][relocate]" )
+{
+    struct Table
+    {
+        auto fc_handles() { return fc::make_tuple(&rows); }
+        fc::SoA<bool, std::int64_t> rows;
+    };
+
+    auto t = fc::make_unique<Table>(4)();
+    auto keys = t->rows.column<1>();
+    std::iota(keys.begin(), keys.end(), 10);
+
+    alignas(Table) std::byte buffer[128];
+    auto r = fc::relocate(t.get(), buffer);
+    CHECK(r->rows.size() == 4);
+    CHECK(r->rows.column<1>()[3] == 13);
+    CHECK(reinterpret_cast<std::byte*>(r->rows.column<0>().data()) == buffer + sizeof(Table));
+}
+
+TEST_CASE( "BitArray packs bits in words", "[bits]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&visited, &links); }
+        std::uint32_t id;
+        fc::BitArray visited;
+        fc::Range<Node*> links;
+    };
+
+    auto n = fc::make_unique<Node>(130, 2)(1u);
+    auto words = n->visited.words();
+    CHECK(words.size() == 3);
+    CHECK(n->visited.size() == 130);
+    CHECK(n->visited.count() == 0);
+    CHECK(n->visited.find_first() == fc::BitArray::npos);
+    CHECK(fc::layout_of<Node>(130, 2).bytes ==
+          fc::findNextAlignedPosition(sizeof(Node), 8) + (1 + 3) * 8 + 2 * sizeof(Node*));
+
+    n->visited.set(3);
+    n->visited.set(64);
+    n->visited.set(129);
+    CHECK(n->visited.test(3));
+    CHECK(!n->visited.test(4));
+    CHECK(n->visited.test(129));
+    CHECK(words[1] == 1);
+    CHECK(n->visited.count() == 3);
+
+    CHECK(n->visited.find_first() == 3);
+    CHECK(n->visited.find_next(3) == 3);
+    CHECK(n->visited.find_next(4) == 64);
+    CHECK(n->visited.find_next(65) == 129);
+    CHECK(n->visited.find_next(130) == fc::BitArray::npos);
+    CHECK(n->visited.find_next(500) == fc::BitArray::npos);
+    CHECK(n->visited.find_next(std::size_t(-1)) == fc::BitArray::npos);
+
+    n->visited.reset(3);
+    n->visited.set(64, false);
+    CHECK(n->visited.count() == 1);
+    CHECK(n->visited.find_first() == 129);
+
+    // Every bit can be reached by find_next
+    std::vector<std::size_t> set;
+    auto m = fc::make_unique<Node>(fc::zeroed(1000), 0)(2u);
+    for (std::size_t i = 0; i < 1000; i += 7)
+        m->visited.set(i);
+    for (auto i = m->visited.find_first(); i != fc::BitArray::npos; i = m->visited.find_next(i + 1))
+        set.push_back(i);
+    CHECK(set.size() == m->visited.count());
+    CHECK(set.size() == 143);
+    CHECK(set.back() == 994);
+
+    auto e = fc::make_unique<Node>(0, 0)(3u);
+    CHECK(e->visited.size() == 0);
+    CHECK(e->visited.words().empty());
+    CHECK(e->visited.find_first() == fc::BitArray::npos);
+}
+
+TEST_CASE( "PackedIntArray stores values in the given number of bits", "[packed]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links, &weights); }
+        std::uint32_t id;
+        fc::PackedIntArray<17> links;
+        fc::Range<float> weights;
+    };
+
+    static_assert(sizeof(fc::PackedIntArray<17>) == sizeof(void*));
+    static_assert(std::is_same_v<fc::PackedIntArray<17>::value_type, std::uint32_t>);
+    static_assert(std::is_same_v<fc::PackedIntArray<40>::value_type, std::uint64_t>);
+
+    std::vector<std::uint32_t> values(300);
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] = std::uint32_t(i * 2654435761u) & ((1u << 17) - 1);
+
+    auto n = fc::make_unique<Node>(fc::arg(values.size(), values.begin()), 2)(1u);
+    REQUIRE(n->links.size() == 300);
+
+    // 300 values of 17 bits take 80 words, after the size
+    auto words = n->links.end(n.get()) - n->links.begin(n.get());
+    CHECK(words == 1 + 80);
+    CHECK(reinterpret_cast<std::byte*>(n->weights.begin()) ==
+          reinterpret_cast<std::byte*>(n->links.end(n.get())));
+
+    bool allEqual = true;
+    for (std::size_t i = 0; i < values.size(); ++i)
+        allEqual &= n->links.get(i) == values[i];
+    CHECK(allEqual);
+
+    // Unaligned head, full blocks and tail
+    std::vector<std::uint32_t> decoded(values.size());
+    auto end = n->links.decode(decoded.begin(), 3, 290);
+    CHECK(end - decoded.begin() == 287);
+    CHECK(std::equal(values.begin() + 3, values.begin() + 290, decoded.begin()));
+
+    n->links.decode(decoded.data(), 0, 300);
+    CHECK(decoded == values);
+
+    n->links.set(3, 0x1ffff);
+    n->links.set(4, 5);
+    CHECK(n->links.get(2) == values[2]);
+    CHECK(n->links.get(3) == 0x1ffff);
+    CHECK(n->links.get(4) == 5);
+    CHECK(n->links.get(5) == values[5]);
+
+    auto f = fc::make_unique<Node>(fc::fill(70, 9u), 0)(2u);
+    std::vector<std::uint64_t> fills(70);
+    f->links.decode(fills.begin(), 0, 70);
+    CHECK(std::all_of(fills.begin(), fills.end(), [](auto v) { return v == 9; }));
+
+    auto z = fc::make_unique<Node>(fc::zeroed(10), 0)(3u);
+    CHECK(z->links.size() == 10);
+    CHECK(z->links.get(9) == 0);
+
+    // Wider values are truncated instead of spilling into their neighbours
+    auto w = fc::make_unique<Node>(fc::fill(70, (1u << 17) | 6u), 0)(4u);
+    CHECK(w->links.get(0) == 6);
+    CHECK(w->links.get(69) == 6);
+    w->links.set(10, (1u << 18) | 3u);
+    CHECK(w->links.get(9) == 6);
+    CHECK(w->links.get(10) == 3);
+    CHECK(w->links.get(11) == 6);
+}
+
+TEST_CASE( "PackedIntArray with 64 bit values and relocation", "[packed][relocate]" )
+{
+    struct Row
+    {
+        auto fc_handles() { return fc::make_tuple(&wide, &narrow); }
+        fc::PackedIntArray<64> wide;
+        fc::PackedIntArray<1> narrow;
+    };
+
+    std::uint64_t big[] = {~std::uint64_t(0), 1, std::uint64_t(1) << 63};
+    auto r = fc::make_unique<Row>(fc::arg(3, std::begin(big)), fc::fill(130, 1))();
+    CHECK(r->wide.get(0) == ~std::uint64_t(0));
+    CHECK(r->wide.get(2) == std::uint64_t(1) << 63);
+    CHECK(r->narrow.get(129) == 1);
+
+    alignas(Row) std::byte buffer[256];
+    auto c = fc::relocate(r.get(), buffer);
+    CHECK(c->wide.size() == 3);
+    CHECK(c->wide.get(1) == 1);
+    CHECK(c->narrow.size() == 130);
+    CHECK(fc::allocated_size(c) == sizeof(Row) + (1 + 3 + 1 + 3) * 8);
+}
+
+namespace {
+    //! Forward iterator counting how many times the elements of "It" are read
+    template <class It>
+    struct CountingIterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename std::iterator_traits<It>::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::iterator_traits<It>::pointer;
+        using reference = typename std::iterator_traits<It>::reference;
+
+        reference operator*() const
+        {
+            ++*m_reads;
+            return *m_it;
+        }
+
+        CountingIterator& operator++()
+        {
+            ++m_it;
+            return *this;
+        }
+
+        bool operator==(const CountingIterator& other) const { return m_it == other.m_it; }
+        bool operator!=(const CountingIterator& other) const { return m_it != other.m_it; }
+
+        It m_it;
+        int* m_reads;
+    };
+}
+
+TEST_CASE( "JaggedArray stores arrays of different sizes in one block", "[jagged]" )
+{
+    struct Graph
+    {
+        auto fc_handles() { return fc::make_tuple(&edges, &weights); }
+        int numNodes;
+        fc::JaggedArray<int> edges;
+        fc::Range<double> weights;
+    };
+
+    std::vector<std::vector<int>> adjacency = {{1, 2}, {}, {0, 1, 3}, {2}};
+    auto g = fc::make_unique<Graph>(fc::arg(adjacency.size(), adjacency.begin()), 3)(4);
+    REQUIRE(g->edges.size() == 4);
+    for (std::size_t i = 0; i < adjacency.size(); ++i)
+        CHECK(std::vector<int>(g->edges[i].begin(), g->edges[i].end()) == adjacency[i]);
+    CHECK(g->edges[1].empty());
+    CHECK(g->edges[2][2] == 3);
+    CHECK(g->edges.elements().size() == 6);
+
+    // 6 ints, then the number of arrays and 4 end offsets
+    auto edgesBytes = (6 + 1 + 4) * sizeof(std::uint32_t);
+    auto edgesBegin = reinterpret_cast<std::byte*>(g->edges.begin(g.get()));
+    CHECK(reinterpret_cast<std::byte*>(g->edges.storage_end(g.get())) == edgesBegin + edgesBytes);
+    CHECK(reinterpret_cast<std::byte*>(g->weights.begin()) ==
+          reinterpret_cast<std::byte*>(fc::findNextAlignedPosition(
+              edgesBegin + edgesBytes, alignof(double))));
+
+    auto layout = fc::layout_of<Graph>(fc::arg(adjacency.size(), adjacency.begin()), 3);
+    CHECK(fc::allocated_size(g.get()) == layout.bytes);
+
+    // Read once to size the block, and once to fill it
+    int reads = 0;
+    CountingIterator<decltype(adjacency.begin())> counting{adjacency.begin(), &reads};
+    auto c = fc::make_unique<Graph>(fc::arg(adjacency.size(), counting), 0)(4);
+    CHECK(reads == 2 * 4);
+    CHECK(c->edges[2][1] == 1);
+
+    // Inner arrays created from their sizes
+    std::size_t sizes[] = {3, 0, 2};
+    auto s = fc::make_unique<Graph>(fc::arg(3, std::begin(sizes)), 0)(3);
+    CHECK(s->edges.size() == 3);
+    CHECK(s->edges[0].size() == 3);
+    CHECK(s->edges[1].size() == 0);
+    CHECK(s->edges[2].size() == 2);
+
+    auto e = fc::make_unique<Graph>(fc::arg(0, std::begin(sizes)), 0)(0);
+    CHECK(e->edges.size() == 0);
+    CHECK(e->edges.elements().empty());
+
+    // A static number of inner arrays still sizes the block from the inner sizes
+    using StaticArgs = decltype(fc::args(fc::arg(fc::static_size<3>, adjacency.begin()),
+                                         fc::static_size<2>));
+    static_assert(!fc::hasStaticLayout<Graph, StaticArgs>::value);
+    auto st = fc::make_unique<Graph>(fc::arg(fc::static_size<3>, adjacency.begin()),
+                                     fc::static_size<2>)(3);
+    REQUIRE(st->edges.size() == 3);
+    CHECK(st->edges[2].size() == 3);
+    CHECK(st->edges[2][1] == 1);
+    CHECK(st->weights.end() - st->weights.begin() == 2);
+}
+
+TEST_CASE( "JaggedArray of non trivial elements is relocated with its index", "[jagged][relocate]" )
+{
+    struct Dictionary
+    {
+        auto fc_handles() { return fc::make_tuple(&words); }
+        std::string name;
+        fc::JaggedArray<std::string, std::uint16_t> words;
+    };
+
+    std::vector<std::vector<std::string>> groups = {
+        {"a long enough string to be allocated", "b"}, {"c"}, {}, {"d", "e", "f"}};
+    auto d = fc::make<Dictionary>(fc::arg(groups.size(), groups.begin()))("letters");
+    CHECK(d->words[0][0] == groups[0][0]);
+
+    auto bytes = fc::allocated_size(d);
+    alignas(Dictionary) std::byte buffer[512];
+    auto r = fc::relocate(d, buffer);
+    ::operator delete(d);
+
+    CHECK(r->name == "letters");
+    REQUIRE(r->words.size() == 4);
+    for (std::size_t i = 0; i < groups.size(); ++i)
+        CHECK(std::vector<std::string>(r->words[i].begin(), r->words[i].end()) == groups[i]);
+    CHECK(fc::allocated_size(r) == bytes);
+    fc::destroy_at(r);
+}
+
+TEST_CASE( "NestedArray creates variable size flexclasses in the parent allocation", "[nested]" )
+{
+    struct Record
+    {
+        auto fc_handles() { return fc::make_tuple(&tags, &values); }
+        int id;
+        fc::Range<std::string> tags;
+        fc::Range<double> values;
+    };
+
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&records, &checksum); }
+        int id;
+        fc::NestedArray<Record, std::uint16_t> records;
+        fc::Range<char> checksum;
+    };
+
+    // Records of the same type, created from the same kinds of arguments
+    std::string tags[] = {"a tag long enough to be allocated", "b", "c"};
+    auto record = [&](std::size_t numTags, std::size_t numValues, double value, int id) {
+        return fc::nested<Record>(fc::arg(numTags, tags), fc::fill(numValues, value))(id);
+    };
+    std::vector<decltype(record(0, 0, 0, 0))> records = {record(3, 2, 1.5, 10),
+                                                         record(0, 0, 0, 11),
+                                                         record(1, 7, 2.5, 12)};
+
+    auto m = fc::make_unique<Message>(fc::arg(records.size(), records.begin()), 4)(1);
+    REQUIRE(m->records.size() == 3);
+    CHECK(m->records[0]->id == 10);
+    CHECK(m->records[0]->tags.begin()[0] == tags[0]);
+    CHECK(m->records[0]->values.end() - m->records[0]->values.begin() == 2);
+    CHECK(m->records[1]->tags.begin() == m->records[1]->tags.end());
+    CHECK(m->records[2]->id == 12);
+    CHECK(m->records[2]->values.begin()[6] == 2.5);
+
+    // Every record lives in the allocation of the message
+    auto begin = reinterpret_cast<std::byte*>(m.get());
+    auto end = begin + fc::allocated_size(m.get());
+    for (std::size_t i = 0; i < m->records.size(); ++i)
+    {
+        auto r = m->records[i];
+        CHECK(reinterpret_cast<std::byte*>(r) > begin);
+        CHECK(reinterpret_cast<std::byte*>(r->values.end()) <= end);
+    }
+    CHECK(fc::allocated_size(m.get()) ==
+          fc::layout_of<Message>(fc::arg(records.size(), records.begin()), 4).bytes);
+    CHECK(reinterpret_cast<std::byte*>(m->checksum.end()) == end);
+
+    // Read once to size the storage, and once to create the records
+    int reads = 0;
+    CountingIterator<decltype(records.begin())> counting{records.begin(), &reads};
+    auto c = fc::make_unique<Message>(fc::arg(records.size(), counting), 4)(1);
+    CHECK(reads == 2 * 3);
+    CHECK(c->records[2]->values.begin()[6] == 2.5);
+    CHECK(fc::allocated_size(c.get()) == fc::allocated_size(m.get()));
+
+    static_assert(!fc::is_trivially_destructible_v<Message>);
+    static_assert(!fc::is_trivially_relocatable_v<Message>);
+
+    // A static number of records still sizes the storage from their layouts
+    auto s = fc::make_unique<Message>(fc::arg(fc::static_size<3>, records.begin()),
+                                      fc::static_size<4>)(2);
+    REQUIRE(s->records.size() == 3);
+    CHECK(s->records[2]->values.begin()[6] == 2.5);
+    CHECK(fc::allocated_size(s.get()) == fc::allocated_size(m.get()));
+}
+
+TEST_CASE( "NestedArray destroys nested flexclasses recursively", "[nested][exception]" )
+{
+    static int alive = 0;
+    static int created = 0;
+    struct Counted
+    {
+        Counted()
+        {
+            if (++created == 6)
+                throw std::runtime_error("Oops");
+            ++alive;
+        }
+        ~Counted() { --alive; }
+    };
+
+    struct Leaf
+    {
+        auto fc_handles() { return fc::make_tuple(&items); }
+        fc::Range<Counted> items;
+    };
+
+    struct Inner
+    {
+        auto fc_handles() { return fc::make_tuple(&leaves); }
+        fc::NestedArray<Leaf> leaves;
+    };
+
+    struct Outer
+    {
+        auto fc_handles() { return fc::make_tuple(&inners); }
+        fc::NestedArray<Inner> inners;
+    };
+
+    std::vector<decltype(fc::nested<Leaf>(0)())> leaves = {fc::nested<Leaf>(2)(),
+                                                           fc::nested<Leaf>(1)()};
+    std::vector<decltype(fc::nested<Inner>(fc::arg(0, leaves.begin()))())> inners = {
+        fc::nested<Inner>(fc::arg(2, leaves.begin()))(),
+        fc::nested<Inner>(fc::arg(1, leaves.begin()))()};
+
+    auto o = fc::make<Outer>(fc::arg(2, inners.begin()))();
+    CHECK(alive == 5);
+    CHECK(o->inners[0]->leaves.size() == 2);
+    CHECK(o->inners[1]->leaves[0]->items.end() - o->inners[1]->leaves[0]->items.begin() == 2);
+    fc::destroy(o);
+    CHECK(alive == 0);
+
+    // The 4th item throws, in the second Inner: the items created so far are destroyed
+    created = 2;
+    CHECK_THROWS_AS(fc::make<Outer>(fc::arg(2, inners.begin()))(), std::runtime_error);
+    CHECK(alive == 0);
+}
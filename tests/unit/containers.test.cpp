@@ -0,0 +1,132 @@
+#include <catch.hpp>
+#include <flexclass.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE( "flex_vector stores objects of different sizes in insertion order", "[flex_vector]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links); }
+        std::size_t id;
+        fc::Range<Node*> links;
+    };
+
+    fc::flex_vector<Node> nodes(1024);
+    CHECK(nodes.empty());
+
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        auto& n = nodes.emplace_back(i % 7)(i);
+        CHECK(&n == &nodes.back());
+        for (auto& l : n.links)
+            l = &nodes.front();
+    }
+
+    REQUIRE(nodes.size() == 1000);
+    CHECK(nodes[0].id == 0);
+    CHECK(nodes[999].id == 999);
+
+    std::size_t i = 0, numChunks = 0;
+    const Node* prev = nullptr;
+    for (auto& n : nodes)
+    {
+        CHECK(n.id == i);
+        CHECK(std::size_t(n.links.end() - n.links.begin()) == i % 7);
+        CHECK(std::all_of(n.links.begin(), n.links.end(), [&](auto l) { return l == &nodes[0]; }));
+
+        // Objects are back-to-back, except when a new chunk starts
+        auto expected = prev ? reinterpret_cast<std::uintptr_t>(prev) +
+                                   fc::findNextAlignedPosition(fc::allocated_size(prev), 16)
+                             : 0;
+        if (reinterpret_cast<std::uintptr_t>(&n) != expected)
+            ++numChunks;
+        prev = &n;
+        ++i;
+    }
+    CHECK(i == 1000);
+    CHECK(numChunks < 10);
+
+    // Moving the container keeps the objects in place
+    auto first = &nodes[0];
+    auto moved = std::move(nodes);
+    CHECK(&moved[0] == first);
+    CHECK(moved.size() == 1000);
+}
+
+TEST_CASE( "flex_vector iterates over objects whose size is not known", "[flex_vector]" )
+{
+    // Without "end", the next object can't be found from the size of the previous one
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&operands, &links); }
+        std::size_t id;
+        fc::PrecedingArray<int> operands;
+        fc::Array<std::size_t> links;
+    };
+    static_assert(!fc::knowsAllocationSize<Node>::value);
+
+    fc::flex_vector<Node> nodes(256);
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        auto& n = nodes.emplace_back(fc::fill(i % 3, int(i)), fc::fill(i % 5, i))(i);
+        CHECK(n.operands.size() == i % 3);
+    }
+
+    std::size_t i = 0;
+    for (auto& n : nodes)
+    {
+        CHECK(n.id == i);
+        CHECK(std::count(n.operands.begin(&n), n.operands.end(&n), int(i)) == int(i % 3));
+        if (i % 5)
+            CHECK(n.links.begin()[i % 5 - 1] == i);
+        ++i;
+    }
+    CHECK(i == 100);
+}
+
+TEST_CASE( "flex_vector destroys its objects", "[flex_vector]" )
+{
+    static int alive = 0;
+    struct Counted
+    {
+        Counted() { ++alive; }
+        Counted(const std::string& s)
+        {
+            if (s == "throw")
+                throw std::runtime_error("Oops");
+            ++alive;
+        }
+        ~Counted() { --alive; }
+    };
+
+    struct Bag
+    {
+        auto fc_handles() { return fc::make_tuple(&items); }
+        std::string name;
+        fc::Range<Counted> items;
+    };
+
+    {
+        fc::flex_vector<Bag> bags;
+        for (int i = 0; i < 10; ++i)
+            bags.emplace_back(i)("bag");
+        CHECK(alive == 45);
+
+        std::string init[] = {"ok", "throw"};
+        CHECK_THROWS_AS(bags.emplace_back(fc::arg(2, std::begin(init)))("bad"), std::runtime_error);
+        CHECK(alive == 45);
+        CHECK(bags.size() == 10);
+
+        bags.clear();
+        CHECK(alive == 0);
+        CHECK(bags.empty());
+
+        bags.emplace_back(3)("reused");
+        CHECK(alive == 3);
+    }
+    CHECK(alive == 0);
+}
@@ -1,8 +1,13 @@
 #include <catch.hpp>
 #include <flexclass.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 struct AllocTrack
 {
@@ -24,14 +29,24 @@ struct AllocTrack
         ::operator delete(ptr);
     }
 
+    void deallocate(void* ptr, std::size_t sz)
+    {
+        auto it = m_ptr2sz.find((uintptr_t)ptr);
+        CHECK(it != m_ptr2sz.end());
+        CHECK(it->second == sz);
+        m_sizedFreeCount++;
+        deallocate(ptr);
+    }
+
     void resetCounters()
     {
-        m_allocd = m_deallocd = m_freeCount = 0;
+        m_allocd = m_deallocd = m_freeCount = m_sizedFreeCount = 0;
     }
 
     std::size_t m_allocd {0};
     std::size_t m_deallocd {0};
     std::size_t m_freeCount {0};
+    std::size_t m_sizedFreeCount {0};
     std::unordered_map<uintptr_t, std::size_t> m_ptr2sz;
 };
 
@@ -59,6 +74,7 @@ TEST_CASE( "Allocate and destroy", "[allocator]" )
 
     CHECK(alloc.m_allocd == 0);
     CHECK(alloc.m_freeCount == 1);
+    CHECK(alloc.m_sizedFreeCount == 0);
 }
 
 TEST_CASE( "Allocate and destroy but forcing sized char", "[allocator]" )
@@ -85,6 +101,7 @@ TEST_CASE( "Allocate and destroy but forcing sized char", "[allocator]" )
 
     CHECK(alloc.m_allocd == 0);
     CHECK(alloc.m_freeCount == 1);
+    CHECK(alloc.m_sizedFreeCount == 1);
 }
 
 TEST_CASE( "Allocate and destroy but using an adjacent array", "[allocator]" )
@@ -111,5 +128,320 @@ TEST_CASE( "Allocate and destroy but using an adjacent array", "[allocator]" )
 
     CHECK(alloc.m_allocd == 0);
     CHECK(alloc.m_freeCount == 1);
+    CHECK(alloc.m_sizedFreeCount == 0);
+}
+
+
+TEST_CASE( "Allocation size is recomputed from the last handle", "[allocator]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&ints, &chars); }
+        char c;
+        fc::Array<int> ints;
+        fc::Range<char> chars;
+    };
+
+    static_assert(fc::knowsAllocationSize<Message>::value);
+
+    AllocTrack alloc;
+
+    auto m = fc::make<Message>(fc::withAllocator, alloc, 3, 5)('a');
+    CHECK(fc::allocationSize(m) == alloc.m_allocd);
+
+    alloc.resetCounters();
+    fc::destroy(m, alloc);
+
+    CHECK(alloc.m_freeCount == 1);
+    CHECK(alloc.m_sizedFreeCount == 1);
+}
+
+TEST_CASE( "Arena serves objects from a single chunk", "[arena]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links); }
+        std::size_t id;
+        fc::AdjacentArray<Node*> links;
+    };
+
+    static_assert(fc::is_trivially_destructible_v<Node>);
+
+    fc::Arena arena;
+
+    Node* prev = nullptr;
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        auto n = fc::make<Node>(fc::withAllocator, arena, 3)(i);
+        CHECK((std::uintptr_t)n % __STDCPP_DEFAULT_NEW_ALIGNMENT__ == 0);
+        if (prev)
+            CHECK((std::uintptr_t)n > (std::uintptr_t)prev);
+        n->links.begin(n)[0] = prev;
+        prev = n;
+    }
+
+    CHECK(arena.capacity() == fc::Arena::defaultChunkSize);
+
+    for (std::size_t i = 100; i > 0; --i)
+    {
+        CHECK(prev->id == i - 1);
+        prev = prev->links.begin(prev)[0];
+    }
+    CHECK(prev == nullptr);
+
+    // Trivially destructible objects don't need to be destroyed one by one
+    arena.reset();
+    CHECK(arena.capacity() == fc::Arena::defaultChunkSize);
+}
+
+TEST_CASE( "Arena grows chunks geometrically and keeps the last one on reset", "[arena]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&data); }
+        std::string str;
+        fc::Range<std::string> data;
+    };
+
+    static_assert(!fc::is_trivially_destructible_v<Message>);
+
+    fc::Arena arena(1024);
+
+    std::vector<Message*> msgs;
+    for (int i = 0; i < 10; ++i)
+        msgs.push_back(fc::make<Message>(fc::withAllocator, arena, 100)("Some message"));
+
+    auto cap = arena.capacity();
+    CHECK(cap > 1024);
+
+    // Objects that own resources must still be destroyed
+    for (auto m : msgs)
+        fc::destroy(m, arena);
+    CHECK(arena.capacity() == cap);
+
+    arena.reset();
+    CHECK(arena.capacity() < cap);
+
+    auto big = fc::make<Message>(fc::withAllocator, arena, 10000)("Large message");
+    CHECK(big->data.end() - big->data.begin() == 10000);
+    fc::destroy(big, arena);
+}
+
+TEST_CASE( "Arena reserves the memory of a whole build from fc::layout_of", "[arena]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links, &weights); }
+        std::size_t id;
+        fc::Range<Node*> links;
+        fc::Range<float> weights;
+    };
+
+    static constexpr std::size_t numNodes = 1000;
+
+    auto layout = fc::layout_of<Node>(3, 5);
+    auto footprint = fc::findNextAlignedPosition(
+        layout.bytes, std::max<std::size_t>(layout.alignment, __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+
+    fc::Arena arena(1024);
+    arena.reserve(numNodes * footprint);
+    auto cap = arena.capacity();
+
+    for (std::size_t i = 0; i < numNodes; ++i)
+    {
+        auto n = fc::make<Node>(fc::withAllocator, arena, 3, 5)(i);
+        CHECK(fc::allocated_size(n) == layout.bytes);
+    }
+    CHECK(arena.capacity() == cap);
+
+    // The reserved bytes start at the next aligned position
+    fc::Arena small(1024);
+    small.allocate(1);
+    small.reserve(1000);
+    cap = small.capacity();
+    small.allocate(1000);
+    CHECK(small.capacity() == cap);
+}
+
+TEST_CASE( "fc::make_n uses a single allocation for all objects", "[allocator][make_n]" )
+{
+    struct Row
+    {
+        auto fc_handles() { return fc::make_tuple(&cells); }
+        int id;
+        fc::Range<std::string> cells;
+    };
+
+    AllocTrack alloc;
+    auto rows = fc::make_n<Row>(fc::withAllocator, alloc, 1000, fc::fill(3, "cell"))(1);
+    CHECK(alloc.m_ptr2sz.size() == 1);
+    CHECK(alloc.m_allocd == rows.size() * rows.stride());
+
+    fc::destroy_n(rows, alloc);
+    CHECK(alloc.m_sizedFreeCount == 1);
+    CHECK(alloc.m_deallocd == alloc.m_allocd);
+}
+
+TEST_CASE( "Pool allocator size classes", "[pool]" )
+{
+    using SC = fc::detail::SizeClasses;
+    for (std::size_t i = 0; i < SC::count; ++i)
+    {
+        CHECK(SC::index(SC::size(i)) == i);
+        CHECK(SC::size(i) % SC::granularity == 0);
+        if (i > 0)
+            CHECK(SC::index(SC::size(i - 1) + 1) == i);
+    }
+    CHECK(SC::size(SC::count - 1) == SC::maxSize);
 }
 
+TEST_CASE( "Pool allocator reuses blocks of the same size class", "[pool]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&data); }
+        std::string str;
+        fc::Range<char> data;
+    };
+
+    fc::PoolAllocator alloc;
+
+    auto m1 = fc::make<Message>(fc::withAllocator, alloc, 100)("First");
+    CHECK((std::uintptr_t)m1 % __STDCPP_DEFAULT_NEW_ALIGNMENT__ == 0);
+    fc::destroy(m1, alloc);
+
+    // A slightly different array size lands in the same size class
+    auto m2 = fc::make<Message>(fc::withAllocator, alloc, 101)("Second");
+    CHECK(m1 == m2);
+    CHECK(m2->str == "Second");
+    fc::destroy(m2, alloc);
+
+    // Larger than any size class
+    auto m3 = fc::make<Message>(fc::withAllocator, alloc, 1 << 20)("Large");
+    CHECK(m3->data.end() - m3->data.begin() == 1 << 20);
+    fc::destroy(m3, alloc);
+}
+
+TEST_CASE( "Pool allocator is usable from multiple threads", "[pool]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&values); }
+        std::size_t id;
+        fc::Range<std::size_t> values;
+    };
+
+    fc::PoolAllocator alloc;
+    std::atomic<bool> corrupted{false};
+
+    auto work = [&](std::size_t offset) {
+        for (int round = 0; round < 10; ++round)
+        {
+            std::vector<Node*> nodes;
+            for (std::size_t i = 0; i < 1000; ++i)
+            {
+                auto n = fc::make<Node>(fc::withAllocator, alloc, i % 50)(offset + i);
+                std::fill(n->values.begin(), n->values.end(), offset + i);
+                nodes.push_back(n);
+            }
+            for (auto n : nodes)
+            {
+                for (auto v : n->values)
+                    if (v != n->id)
+                        corrupted = true;
+                fc::destroy(n, alloc);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; ++t)
+        threads.emplace_back(work, t * 1000);
+    for (auto& t : threads)
+        t.join();
+    CHECK(!corrupted);
+
+    // Blocks allocated by one thread and freed by another one go through the
+    // depot: a third thread gets them back
+    constexpr std::size_t numNodes = 200;
+    std::vector<Node*> nodes(numNodes);
+    std::thread([&] {
+        for (std::size_t i = 0; i < numNodes; ++i)
+            nodes[i] = fc::make<Node>(fc::withAllocator, alloc, 50)(i);
+    }).join();
+    std::thread([&] {
+        for (auto n : nodes)
+            fc::destroy(n, alloc);
+    }).join();
+
+    std::vector<Node*> reused(numNodes);
+    std::thread([&] {
+        for (std::size_t i = 0; i < numNodes; ++i)
+            reused[i] = fc::make<Node>(fc::withAllocator, alloc, 50)(i);
+    }).join();
+
+    std::sort(nodes.begin(), nodes.end());
+    std::sort(reused.begin(), reused.end());
+    CHECK(reused == nodes);
+    for (auto n : reused)
+        fc::destroy(n, alloc);
+}
+
+TEST_CASE( "Zeroed arrays are cleared with a single memset", "[zeroed]" )
+{
+    struct Bitmap
+    {
+        auto fc_handles() { return fc::make_tuple(&counters, &name, &bits); }
+        int id;
+        fc::Range<int> counters;
+        fc::Range<char> name;
+        fc::Range<std::uint64_t> bits;
+    };
+
+    for (int i = 0; i < 10; ++i)
+    {
+        // Dirty the heap so the memory is unlikely to be zero already
+        std::vector<int> garbage(1000, -1);
+        garbage.clear();
+        garbage.shrink_to_fit();
+
+        auto m = fc::make_unique<Bitmap>(fc::zeroed(100), fc::fill(5, 'x'), fc::zeroed(10))(i);
+        CHECK(m->id == i);
+        CHECK(std::all_of(m->counters.begin(), m->counters.end(), [](int c) { return c == 0; }));
+        CHECK(std::string(m->name.begin(), m->name.end()) == "xxxxx");
+        CHECK(m->bits.end() - m->bits.begin() == 10);
+        CHECK(std::all_of(m->bits.begin(), m->bits.end(), [](auto b) { return b == 0; }));
+    }
+}
+
+TEST_CASE( "Zeroed arrays are not written when the allocator provides zeroed memory", "[zeroed]" )
+{
+    struct CallocAlloc
+    {
+        void* allocate(std::size_t sz) { m_allocCount++; return std::malloc(sz); }
+        void* allocate_zeroed(std::size_t sz) { m_zeroedCount++; return std::calloc(1, sz); }
+        void deallocate(void* ptr) { std::free(ptr); }
+        int m_allocCount {0};
+        int m_zeroedCount {0};
+    };
+
+    struct Counters
+    {
+        auto fc_handles() { return fc::make_tuple(&counters); }
+        fc::Range<long> counters;
+    };
+
+    CallocAlloc alloc;
+
+    auto m = fc::make<Counters>(fc::withAllocator, alloc, fc::zeroed(1 << 20))();
+    CHECK(alloc.m_zeroedCount == 1);
+    CHECK(alloc.m_allocCount == 0);
+    CHECK(std::all_of(m->counters.begin(), m->counters.end(), [](long c) { return c == 0; }));
+    fc::destroy(m, alloc);
+
+    // Without zeroed arrays the regular allocation is used
+    m = fc::make<Counters>(fc::withAllocator, alloc, 10)();
+    CHECK(alloc.m_zeroedCount == 1);
+    CHECK(alloc.m_allocCount == 1);
+    fc::destroy(m, alloc);
+}
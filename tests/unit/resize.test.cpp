@@ -0,0 +1,462 @@
+#include <catch.hpp>
+#include <flexclass.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct CountingAllocator
+{
+    void* allocate(std::size_t sz)
+    {
+        ++m_allocCount;
+        return ::operator new(sz);
+    }
+    void deallocate(void* ptr, std::size_t sz)
+    {
+        ++m_freeCount;
+        ::operator delete(ptr, sz);
+    }
+    void deallocate(void* ptr) { ::operator delete(ptr); }
+
+    std::size_t m_allocCount {0};
+    std::size_t m_freeCount {0};
+};
+}
+
+TEST_CASE( "Resizing the last array relocates the object", "[resize]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links); }
+        std::size_t id;
+        fc::Range<std::size_t> links;
+    };
+
+    std::vector<std::size_t> init(5);
+    std::iota(init.begin(), init.end(), 0);
+    auto n = fc::make<Node>(fc::arg(init.size(), init.begin()))(std::size_t(42));
+
+    n = fc::resize<0>(n, 8);
+    CHECK(n->id == 42);
+    REQUIRE(n->links.end() - n->links.begin() == 8);
+    CHECK(std::equal(init.begin(), init.end(), n->links.begin()));
+    CHECK(fc::allocated_size(n) == fc::layout_of<Node>(8).bytes);
+
+    n = fc::resize<0>(n, 2);
+    REQUIRE(n->links.end() - n->links.begin() == 2);
+    CHECK(n->links.begin()[1] == 1);
+    CHECK(fc::allocated_size(n) == fc::layout_of<Node>(2).bytes);
+
+    fc::destroy(n);
+}
+
+TEST_CASE( "Resizing an array in the middle moves all arrays", "[resize]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&header, &tags, &payload); }
+        int id;
+        fc::AdjacentRange<char> header;
+        fc::Range<std::string> tags;
+        fc::Range<double> payload;
+    };
+
+    std::string tags[] = {"a long tag that is not in the small buffer", "b", "c"};
+    auto m = fc::make<Message>(fc::fill(4, 'h'), fc::arg(3, std::begin(tags)), fc::fill(3, 1.5))(7);
+
+    CountingAllocator alloc;
+    m = fc::resize<1>(m, alloc, 5);
+    CHECK(alloc.m_allocCount == 1);
+    CHECK(alloc.m_freeCount == 1);
+
+    CHECK(m->id == 7);
+    CHECK(std::string(m->header.begin(m), m->header.end(m)) == "hhhh");
+    REQUIRE(m->tags.end() - m->tags.begin() == 5);
+    CHECK(std::equal(std::begin(tags), std::end(tags), m->tags.begin()));
+    CHECK(m->tags.begin()[4].empty());
+    CHECK(std::count(m->payload.begin(), m->payload.end(), 1.5) == 3);
+
+    auto layout = fc::layout_of<Message>(4, 5, 3);
+    auto base = reinterpret_cast<std::byte*>(m);
+    CHECK(reinterpret_cast<std::byte*>(m->tags.begin()) == base + layout.offsets[1]);
+    CHECK(reinterpret_cast<std::byte*>(m->payload.begin()) == base + layout.offsets[2]);
+
+    m = fc::resize<1>(m, alloc, 1);
+    REQUIRE(m->tags.end() - m->tags.begin() == 1);
+    CHECK(m->tags.begin()[0] == tags[0]);
+    CHECK(std::count(m->payload.begin(), m->payload.end(), 1.5) == 3);
+
+    fc::destroy(m, alloc);
+}
+
+TEST_CASE( "GrowableRange grows geometrically", "[resize]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links, &name); }
+        fc::GrowableRange<Node*> links;
+        fc::Range<char> name;
+    };
+
+    CountingAllocator alloc;
+    auto n = fc::make<Node>(fc::withAllocator, alloc, 0, fc::fill(3, 'n'))();
+    CHECK(n->links.capacity() == 0);
+
+    std::size_t numRelocations = 0;
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        auto size = n->links.size();
+        auto prev = n;
+        n = fc::resize<0>(n, alloc, size + 1, fc::geometric_growth);
+        n->links.begin()[size] = prev;
+        if (n != prev)
+            ++numRelocations;
+    }
+
+    CHECK(numRelocations == alloc.m_allocCount - 1);
+    CHECK(numRelocations <= 11);
+    CHECK(n->links.size() == 1000);
+    CHECK(n->links.capacity() >= 1000);
+    CHECK(std::string(n->name.begin(), n->name.end()) == "nnn");
+    CHECK(fc::allocated_size(n) == fc::layout_of<Node>(n->links.capacity(), 3).bytes);
+
+    // Shrinking keeps the capacity
+    auto prev = n;
+    n = fc::resize<0>(n, alloc, 10, fc::geometric_growth);
+    CHECK(n == prev);
+    CHECK(n->links.size() == 10);
+
+    fc::destroy(n, alloc);
+    CHECK(alloc.m_freeCount == alloc.m_allocCount);
+}
+
+TEST_CASE( "The last array grows in place when the allocator can expand", "[resize]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links); }
+        std::size_t id;
+        fc::Range<int> links;
+    };
+
+    SECTION( "Arena" )
+    {
+        fc::Arena arena;
+        auto first = fc::make<Node>(fc::withAllocator, arena, 2)(std::size_t(1));
+        auto n = fc::make<Node>(fc::withAllocator, arena, 2)(std::size_t(2));
+
+        // Only the most recent allocation can grow
+        CHECK(fc::resize<0>(n, arena, 100) == n);
+        CHECK(n->links.end() - n->links.begin() == 100);
+        CHECK(n->id == 2);
+        CHECK(fc::resize<0>(first, arena, 3) != first);
+
+    }
+
+    SECTION( "Pool allocator" )
+    {
+        fc::PoolAllocator pool;
+        auto n = fc::make<Node>(fc::withAllocator, pool, 1)(std::size_t(2));
+        auto bytes = fc::allocated_size(n);
+        auto classSize = fc::detail::SizeClasses::size(fc::detail::SizeClasses::index(bytes));
+        auto fits = 1 + (classSize - bytes) / sizeof(int);
+
+        CHECK(fc::resize<0>(n, pool, fits) == n);
+        n = fc::resize<0>(n, pool, fits + 1);
+        CHECK(std::size_t(n->links.end() - n->links.begin()) == fits + 1);
+        CHECK(n->id == 2);
+        fc::destroy(n, pool);
+    }
+}
+
+TEST_CASE( "A failed resize leaves the object untouched", "[resize][exception]" )
+{
+    static int created = 0;
+    struct Throwing
+    {
+        Throwing()
+        {
+            if (++created > 3)
+                throw std::runtime_error("Oops");
+        }
+        Throwing(Throwing&&) noexcept = default;
+        int value {5};
+    };
+
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&items, &ids); }
+        fc::Range<Throwing> items;
+        fc::Range<int> ids;
+    };
+
+    auto n = fc::make<Node>(2, fc::fill(2, 9))();
+    CHECK_THROWS_AS(fc::resize<0>(n, 5), std::runtime_error);
+    REQUIRE(n->items.end() - n->items.begin() == 2);
+    CHECK(n->items.begin()[1].value == 5);
+    CHECK(n->ids.begin()[1] == 9);
+    fc::destroy(n);
+}
+
+TEST_CASE( "Adjacent arrays follow the storage of a GrowableRange", "[resize]" )
+{
+    struct Node
+    {
+        auto fc_handles() { return fc::make_tuple(&links, &weights); }
+        fc::GrowableRange<int> links;
+        fc::AdjacentRange<double, 0> weights;
+    };
+
+    auto n = fc::make<Node>(3, fc::fill(2, 0.5))();
+    n = fc::resize<0>(n, 4, fc::geometric_growth);
+    CHECK(n->links.capacity() == 6);
+    CHECK(reinterpret_cast<std::byte*>(n->weights.begin(n)) >=
+          reinterpret_cast<std::byte*>(n->links.begin() + 6));
+    CHECK(std::count(n->weights.begin(n), n->weights.end(n), 0.5) == 2);
+
+    n = fc::resize<1>(n, 3);
+    CHECK(n->links.capacity() == 6);
+    CHECK(std::count(n->weights.begin(n), n->weights.end(n), 0.5) == 2);
+    fc::destroy(n);
+}
+
+namespace
+{
+struct Buffer
+{
+    Buffer() : m_data(new char[16]) {}
+    Buffer(Buffer&& other) noexcept : m_data(std::exchange(other.m_data, nullptr)) {}
+    ~Buffer() { delete[] m_data; }
+    char* m_data;
+};
+}
+
+template <>
+struct fc::is_trivially_relocatable<Buffer> : std::true_type
+{
+};
+
+TEST_CASE( "Trivially relocatable objects", "[relocate]" )
+{
+    struct Message
+    {
+        auto fc_handles() { return fc::make_tuple(&c, &d); }
+        int a;
+        double b;
+        fc::Array<long> c;
+        fc::Range<float> d;
+    };
+
+    struct Named
+    {
+        auto fc_handles() { return fc::make_tuple(&names); }
+        fc::Range<std::string> names;
+    };
+
+    struct Buffers
+    {
+        auto fc_handles() { return fc::make_tuple(&buffers); }
+        fc::Range<Buffer> buffers;
+    };
+
+    static_assert(fc::is_trivially_relocatable_v<int>);
+    static_assert(!fc::is_trivially_relocatable_v<std::string>);
+    static_assert(fc::is_trivially_relocatable_v<Message>);
+    static_assert(!fc::is_trivially_relocatable_v<Named>);
+    static_assert(fc::is_trivially_relocatable_v<Buffers>);
+}
+
+TEST_CASE( "Relocating an object moves its arrays and updates its handles", "[relocate]" )
+{
+    SECTION( "Trivially relocatable" )
+    {
+        struct Message
+        {
+            auto fc_handles() { return fc::make_tuple(&c, &d); }
+            int a;
+            fc::Array<long> c;
+            fc::Range<float> d;
+        };
+
+        fc::Arena from, to;
+        auto m = fc::make<Message>(fc::withAllocator, from, fc::fill(3, 7l), fc::fill(2, 1.5f))(1);
+        auto bytes = fc::allocated_size(m);
+
+        auto r = fc::relocate(m, to.allocate(bytes));
+        from.reset();
+
+        CHECK(r->a == 1);
+        CHECK(r->c.begin()[2] == 7);
+        REQUIRE(r->d.end() - r->d.begin() == 2);
+        CHECK(r->d.begin()[1] == 1.5f);
+        CHECK(reinterpret_cast<std::byte*>(r->c.begin()) > reinterpret_cast<std::byte*>(r));
+        CHECK(fc::allocated_size(r) == bytes);
+    }
+
+    SECTION( "Non trivially relocatable" )
+    {
+        struct Named
+        {
+            auto fc_handles() { return fc::make_tuple(&names, &buffers); }
+            std::string name;
+            fc::Range<std::string> names;
+            fc::Range<Buffer> buffers;
+        };
+
+        std::string names[] = {"a name that does not fit in the small buffer", "b"};
+        auto n = fc::make<Named>(fc::arg(2, std::begin(names)), 2)("named");
+        auto data = n->buffers.begin()[1].m_data;
+        auto layout = fc::layout_of<Named>(2, 2);
+
+        alignas(Named) std::byte buffer[512];
+        auto r = fc::relocate(n, buffer);
+        ::operator delete(n);
+
+        CHECK(reinterpret_cast<std::byte*>(r) == buffer);
+        CHECK(r->name == "named");
+        CHECK(std::equal(std::begin(names), std::end(names), r->names.begin(), r->names.end()));
+        CHECK(r->buffers.begin()[1].m_data == data);
+        CHECK(reinterpret_cast<std::byte*>(r->names.begin()) == buffer + layout.offsets[0]);
+        CHECK(reinterpret_cast<std::byte*>(r->buffers.begin()) == buffer + layout.offsets[1]);
+        fc::destroy_at(r);
+    }
+}
+
+TEST_CASE( "Relocating keeps the room reserved by a GrowableRange", "[resize][relocate]" )
+{
+    SECTION( "Trivially relocatable" )
+    {
+        struct Node
+        {
+            auto fc_handles() { return fc::make_tuple(&links, &name); }
+            fc::GrowableRange<int> links;
+            fc::Range<char> name;
+        };
+
+        CountingAllocator alloc;
+        auto n = fc::make<Node>(fc::withAllocator, alloc, 3, fc::fill(3, 'n'))();
+        n = fc::resize<0>(n, alloc, 5, fc::geometric_growth);
+        REQUIRE(n->links.capacity() > 5);
+        auto capacity = n->links.capacity();
+        auto bytes = fc::allocated_size(n);
+
+        alignas(Node) std::byte buffer[256];
+        auto r = fc::relocate(n, buffer);
+        alloc.deallocate(n, bytes);
+
+        CHECK(r->links.size() == 5);
+        CHECK(r->links.capacity() == capacity);
+        CHECK(fc::allocated_size(r) == bytes);
+        CHECK(std::string(r->name.begin(), r->name.end()) == "nnn");
+        CHECK(alloc.m_allocCount == alloc.m_freeCount);
+    }
+
+    SECTION( "Non trivially relocatable" )
+    {
+        struct Node
+        {
+            auto fc_handles() { return fc::make_tuple(&names); }
+            std::string label;
+            fc::GrowableRange<std::string> names;
+        };
+
+        auto n = fc::make<Node>(fc::fill(3, std::string(40, 'n')))("node");
+        n = fc::resize<0>(n, 5, fc::geometric_growth);
+        REQUIRE(n->names.capacity() > 5);
+        auto capacity = n->names.capacity();
+        auto bytes = fc::allocated_size(n);
+
+        alignas(Node) std::byte buffer[512];
+        auto r = fc::relocate(n, buffer);
+        ::operator delete(n);
+
+        CHECK(r->label == "node");
+        CHECK(r->names.size() == 5);
+        CHECK(r->names.begin()[2] == std::string(40, 'n'));
+        CHECK(r->names.capacity() == capacity);
+        CHECK(fc::allocated_size(r) == bytes);
+        fc::destroy_at(r);
+    }
+}
+
+TEST_CASE( "Objects with preceding arrays are resized and relocated", "[resize][relocate]" )
+{
+    struct User
+    {
+        auto fc_handles() { return fc::make_tuple(&operands, &names); }
+        fc::PrecedingArray<std::string> operands;
+        std::uint32_t opcode;
+        fc::Range<std::string> names;
+    };
+
+    CountingAllocator alloc;
+    auto u = fc::make<User>(fc::withAllocator, alloc, fc::fill(2, std::string(40, 'o')), 1)(0u, 3u);
+
+    SECTION( "Growing the preceding array" )
+    {
+        u = fc::resize<0>(u, alloc, 5);
+        CHECK(u->opcode == 3);
+        REQUIRE(u->operands.size() == 5);
+        CHECK(u->operands.end(u) == reinterpret_cast<std::string*>(u));
+        CHECK(u->operands.begin(u)[1] == std::string(40, 'o'));
+        CHECK(u->operands.begin(u)[4].empty());
+        CHECK(fc::allocated_size(u) == fc::layout_of<User>(5, 1).bytes);
+    }
+
+    SECTION( "Growing the array after the base" )
+    {
+        u = fc::resize<1>(u, alloc, 4);
+        CHECK(u->operands.begin(u)[0] == std::string(40, 'o'));
+        CHECK(u->names.end() - u->names.begin() == 4);
+    }
+
+    SECTION( "Relocating" )
+    {
+        auto layout = fc::layout_of<User>(2, 1);
+        auto mem = fc::allocationBegin(u);
+        alignas(User) std::byte buffer[256];
+        auto r = fc::relocate(u, buffer);
+        alloc.deallocate(mem, layout.bytes);
+        u = nullptr;
+
+        CHECK(reinterpret_cast<std::byte*>(r) == buffer + layout.baseOffset);
+        CHECK(r->opcode == 3);
+        CHECK(r->operands.begin(r)[1] == std::string(40, 'o'));
+        CHECK(reinterpret_cast<std::byte*>(r->names.begin()) == buffer + layout.offsets[1]);
+        fc::destroy_at(r);
+    }
+
+    fc::destroy(u, alloc);
+    CHECK(alloc.m_allocCount == alloc.m_freeCount);
+}
+
+TEST_CASE( "Resizing follows the sorted layout", "[resize][layout]" )
+{
+    struct Packet
+    {
+        using fc_layout_policy = fc::SortByAlignment;
+        auto fc_handles() { return fc::make_tuple(&flags, &values); }
+        std::uint32_t id;
+        fc::Range<char> flags;
+        fc::Range<double> values;
+    };
+
+    fc::Arena arena;
+    auto p = fc::make<Packet>(fc::withAllocator, arena, fc::fill(3, 'f'), fc::fill(2, 0.5))(1u);
+
+    // The chars are laid out last, so they grow with the allocation
+    CHECK(fc::resize<0>(p, arena, 20) == p);
+    CHECK(p->flags.end() - p->flags.begin() == 20);
+    CHECK(fc::allocated_size(p) == fc::layout_of<Packet>(20, 2).bytes);
+
+    p = fc::resize<1>(p, arena, 4);
+    CHECK(p->values.begin()[1] == 0.5);
+    CHECK(p->flags.begin()[2] == 'f');
+    CHECK(reinterpret_cast<std::byte*>(p->values.begin()) <
+          reinterpret_cast<std::byte*>(p->flags.begin()));
+}